@@ -15,7 +15,7 @@
 Entity::Entity(const std::string &name, double x, double y, double z, double r, double w, Color c) : name(name), x_pos(x), y_pos(y),z_pos(z), radius(r), weight(w), color(c) {}
 
 
-void Entity::showInfo(){
+void Entity::showInfo() const {
     // Draw textual debug info on screen (not console)
     DrawText(("Entity: " + this->get_name()).c_str(), 10, 10, 10, BLACK);
     DrawText(("Position: (" + std::to_string(this->get_x()) + ", " + std::to_string(this->get_y()) + ")").c_str(), 10, 25, 10, BLACK);
@@ -25,12 +25,20 @@ void Entity::showInfo(){
     DrawText(("Weight: " + std::to_string(this->getWeight())).c_str(), 10, 70, 10, BLACK);
 }
 std::string Entity::get_name() const {
+        // Bulk spawns leave the name empty so no string is built per entity; format it only when asked.
+        if (name.empty()) return "player " + std::to_string(id + 1);
         return name;
     }
 
 void Entity::set_name(const std::string &new_name) {
     name = new_name;
     }
+int Entity::get_id() const {
+    return id;
+    }
+void Entity::set_id(int id) {
+    this->id = id;
+    }
 double Entity::get_x() const {
     return x_pos;
     }
@@ -80,12 +88,6 @@ void Entity::set_color(Color color) {
 Color Entity::get_color() const {
     return color;
 }
-void Entity::setColliding(bool status) {
-    isColliding = status;
-}
-bool Entity::getCollided() const {
-    return isColliding;
-}
 bool Entity::getOnGround() const{
     return isOnGround;
 }
@@ -110,12 +112,6 @@ void Entity::setAtRight(bool status){
 void Entity::setAtCeiling(bool status){
     isAtCeiling = status;
 }
-bool Entity::isMarkedForDeletion() const {
-    return markedForDeletion;
-}
-void Entity::markedForDeletionStatus(bool status) {
-    markedForDeletion = status;
-}
 void Entity::setCanMove(bool status) {
     canMove = status;
 }
@@ -123,13 +119,11 @@ bool Entity::getCanMove() const {
     return canMove;
 }
 void Entity::resetFlags() {
-   // Reset per-frame state so next frame recomputes collisions/boundary states
-   setColliding(false);
+   // Reset per-frame state so next frame recomputes boundary states
     setOnGround(false);
     setAtCeiling(false);
     setAtLeft(false);
     setAtRight(false);
-    setStatic(false);
 }
 bool Entity::getEntityBouncy() const {
     return isBouncy;
@@ -154,4 +148,16 @@ void Entity::setIsbouncing(bool status) {
 }
 bool Entity::getIsbouncing() const {
     return isBouncy;
-}
\ No newline at end of file
+}
+void Entity::setCollisionLayer(uint32_t layer) {
+    collisionLayer = layer;
+}
+uint32_t Entity::getCollisionLayer() const {
+    return collisionLayer;
+}
+void Entity::setCollisionMask(uint32_t mask) {
+    collisionMask = mask;
+}
+uint32_t Entity::getCollisionMask() const {
+    return collisionMask;
+}
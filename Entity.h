@@ -3,10 +3,20 @@
 
 #ifndef Entity_H
 #define Entity_H
+#include <cstdint>
 #include <string>
 #include "raylib.h"
 #include "config.h"
 
+/**
+ * @brief Stable reference to a pooled entity: slot plus the slot's generation at the time it was taken.
+ * A released and reused slot bumps its generation, so stale handles can be detected (see resolveHandle).
+ */
+struct entityHandle {
+    int slot{-1};
+    unsigned int generation{0};
+};
+
 /**
  * @brief Simple circular entity used by the physics demo.
  *
@@ -17,7 +27,8 @@
 class Entity{
     
     private:
-    std::string name{"Player"};
+    std::string name; ///< optional; empty names are synthesized from the slot id on demand
+    int id{-1}; ///< slot index in the players pool (-1 when not pooled)
     Color color{GREEN};
     double x_pos{0.0};
     double y_pos{0.0};
@@ -26,15 +37,15 @@ class Entity{
     double vx{0.0};
     double vy{0.0};
     double weight{0.0};
-    bool isColliding{false};
     bool isStatic{false};
     bool isOnGround{false};
     bool isAtCeiling{false};
     bool isAtLeft{false};
     bool isAtRight{false};
-    bool markedForDeletion{false};
     bool canMove{false};
     bool isBouncy{true};
+    uint32_t collisionLayer{LAYER_DEFAULT}; ///< layers this body is on
+    uint32_t collisionMask{LAYER_ALL};      ///< layers this body collides with
     
     public:
     Entity() = default;
@@ -53,6 +64,8 @@ class Entity{
     // Accessors and mutators
     std::string get_name() const;
     void set_name(const std::string &new_name);
+    int get_id() const;
+    void set_id(int id);
     double get_x() const;
     void set_x(double x);
     double get_y() const;
@@ -74,11 +87,9 @@ class Entity{
 
     // Input, bounds and physics helpers
     void setVelocity(double vx, double vy);
-    void showInfo(); ///< debug: draw entity info on screen
+    void showInfo() const; ///< debug: draw entity info on screen
 
-    // Collision / lifecycle flags
-    bool getCollided() const;
-    void setColliding(bool status);
+    // Boundary flags (pair contacts are reported through contactStream; deletion goes through entityCommands)
     bool getOnGround() const;
     bool getAtCeiling() const;
     void setOnGround(bool status);
@@ -87,13 +98,17 @@ class Entity{
     bool getAtLeft() const;
     bool getAtRight() const;
     void setAtRight(bool status);
-    void markedForDeletionStatus(bool status);
-    bool isMarkedForDeletion() const;
-    void resetFlags(); ///< reset collision and state flags each frame
+    void resetFlags(); ///< reset boundary flags each frame (static is persistent; see setStatic)
     bool getEntityBouncy() const;
     void setEntityBouncy(bool status);
+    /** Static bodies are pinned: never integrated or pushed, and kept in their own broadphase (staticGrid). */
     void setStatic(bool status);
     bool getEntityStatic() const;
+    // Collision filtering: a pair is tested only when each body's layer is in the other's mask.
+    void setCollisionLayer(uint32_t layer);
+    uint32_t getCollisionLayer() const;
+    void setCollisionMask(uint32_t mask);
+    uint32_t getCollisionMask() const;
     void setIsbouncing(bool status);
     bool getIsbouncing() const;
 };
@@ -1,110 +1,282 @@
 // physicsEffects implementation: gravity integration, bounce handling, and friction damping.
-// All updates use dt = GetFrameTime() and treat GRAVITY as pixels/s^2.
+// All updates use the simulation step dt and treat GRAVITY as pixels/s^2. Each body is integrated in
+// 2^level substeps of dt; pair resolution still happens once per step, at the coarse boundary.
 
 #include <cmath>
 #include "physicsEffects.h"
 #include "Entity.h"
 #include "raylib.h"
 #include "config.h"
+#include "commands.h"
+#include "parallel.h"
 #include <algorithm>
 
 
-void physicsEffects::applyGravity(){
-    double dt = GetFrameTime();
-    int height = GetScreenHeight();
+void physicsEffects::setGravity(double g){
+    gravity = g;
+}
 
-    for (Entity *entity : entity_ptr) {
-        if (!entity) continue;
-        // If entity is on the ground and NOT bouncy, keep it clamped and skip gravity.
-        if (entity->getOnGround() && !entity->getEntityBouncy()) {
-            entity->set_vy(0.0);
-            entity->set_y(height - entity->get_radius());
-            entity->set_x(entity->get_x() + entity->get_vx() * dt);
-            continue;
+// Per-worker partial sum of the mutual potential, padded like integratePartial below.
+struct alignas(64) potentialPartial {
+    double energy{0.0};
+};
+
+void physicsEffects::applyMutualGravity(const quadTree &tree, const gravityParams &params, double dt, bool measurePotential){
+    mutualPotential = 0.0;
+    if (tree.empty()) return;
+    std::vector<potentialPartial> partials(measurePotential ? parallelWorkerCount() : 0);
+    parallelFor(static_cast<int>(entity_ptr.size()), 1024, [&](int begin, int end, int worker) {
+        for (int i = begin; i < end; ++i) {
+            Entity *entity = entity_ptr[i];
+            if (!entity) continue;
+            double ax, ay, phi;
+            tree.gravityAt(static_cast<float>(entity->get_x()), static_cast<float>(entity->get_y()),
+                           entity->get_id(), params, ax, ay, measurePotential ? &phi : nullptr);
+            entity->addToVx(ax * dt);
+            entity->addToVy(ay * dt);
+            stepHistory.markChanged(i);
+            // Each pair is seen from both ends, hence the half.
+            if (measurePotential) partials[worker].energy += 0.5 * std::max(1.0, entity->getWeight()) * phi;
         }
-        // Gravity is an acceleration (pixels/s^2). Apply per-frame velocity change.
-        entity->addToVy(GRAVITY * dt);
-        if (entity->get_vy() > MAX_FALL_SPEED)
-            entity->set_vy(MAX_FALL_SPEED);
+    });
+    for (const potentialPartial &partial : partials) mutualPotential += partial.energy;
+}
 
-        // Integrate positions using velocity * dt (consistent units)
-        entity->set_y(entity->get_y() + entity->get_vy() * dt);
-        entity->set_x(entity->get_x() + entity->get_vx() * dt);
+// Per-worker partial sums, padded to a cache line so workers never share one.
+struct alignas(64) integratePartial {
+    double kinetic{0.0};
+    double potential{0.0};
+    double momentumX{0.0};
+    double momentumY{0.0};
+    int bodies{0};
+    int asleep{0};
+    int histogram[MAX_SUBSTEP_LEVEL + 1]{};
+};
 
-        // Ground collision handling: clamp to floor and resolve vertical velocity.
-        if (entity->get_y() + entity->get_radius() >= height) {
-            entity->set_y(height - entity->get_radius());
-            // Use weight (mass) to influence bounce response in a stable way.
-            double mass = std::max(1.0, entity->getWeight());
-            // massBounceFactor reduces rebound for heavier objects (tunable constant)
-            const double k = 0.02; // tuning constant
-            double massBounceFactor = 1.0 / (1.0 + (mass - 1.0) * k);
-
-            if (entity->getEntityBouncy()) {
-                double preVy = entity->get_vy();
-                double targetVy = -preVy * BOUNCE * massBounceFactor; // mass-scaled rebound
-                if (targetVy < -MAX_FLY_SPEED) {
-                    targetVy = -MAX_FLY_SPEED; // clamp upward speed magnitude
-                }
-                entity->set_vy(targetVy); // assign clamped bounce velocity
-                // Only mark bouncy entity as on-ground if bounce is effectively finished
-                if (std::abs(entity->get_vy()) < 0.3) {
-                    entity->set_vy(0.0);
-                    entity->setOnGround(true);
-                }
-            } 
-            else {
-                // Non-bouncy: stop downward movement and mark on-ground
-                if (entity->get_vy() > 0.0) {
-                    entity->set_vy(0.0);
+// substepLevels value for a sleeping body (no integration this step).
+static constexpr unsigned char SLEEPING_LEVEL = 0xFF;
+
+void physicsEffects::applyGravity(double dt, stepDiagnostics *diagnostics){
+    // World size is published by the render thread; raylib's window queries are main-thread only.
+    int width = worldWidth.load(std::memory_order_relaxed);
+    int height = worldHeight.load(std::memory_order_relaxed);
+
+    assignSubstepLevels(dt);
+    std::vector<integratePartial> partials(parallelWorkerCount());
+    const bool measure = diagnostics != nullptr;
+    parallelFor(static_cast<int>(entity_ptr.size()), 2048, [&](int begin, int end, int worker) {
+        integratePartial &partial = partials[worker];
+        for (int i = begin; i < end; ++i) {
+            Entity *entity = entity_ptr[i];
+            if (!entity) continue;
+            int level = substepLevels[entity->get_id()];
+            if (level == SLEEPING_LEVEL || entity->getEntityStatic()) {
+                ++partial.asleep; // pinned bodies are counted with the sleepers: neither is integrated
+            } else {
+                ++partial.histogram[level];
+                int steps = 1 << level;
+                double h = dt / steps;
+                for (int s = 0; s < steps; ++s) {
+                    integrate(entity, h, width, height);
                 }
-                entity->setOnGround(true);
+                stepHistory.markChanged(i); // sleeping and pinned bodies are left out of the next history delta
+            }
+            if (measure) {
+                // Fused reduction: the body is hot in cache right after integration.
+                double m = std::max(1.0, entity->getWeight());
+                double vx = entity->get_vx(), vy = entity->get_vy();
+                partial.kinetic += 0.5 * m * (vx * vx + vy * vy);
+                partial.potential += m * gravity * (height - entity->get_y());
+                partial.momentumX += m * vx;
+                partial.momentumY += m * vy;
+                ++partial.bodies;
             }
         }
+    });
+
+    for (int level = 0; level <= MAX_SUBSTEP_LEVEL; ++level) substepHistogram[level] = 0;
+    double kinetic = 0.0, potential = mutualPotential, momentumX = 0.0, momentumY = 0.0;
+    mutualPotential = 0.0;
+    int bodies = 0;
+    sleepingBodies = 0;
+    for (const integratePartial &partial : partials) {
+        sleepingBodies += partial.asleep;
+        for (int level = 0; level <= MAX_SUBSTEP_LEVEL; ++level) substepHistogram[level] += partial.histogram[level];
+        kinetic += partial.kinetic;
+        potential += partial.potential;
+        momentumX += partial.momentumX;
+        momentumY += partial.momentumY;
+        bodies += partial.bodies;
+    }
+    if (diagnostics) {
+        diagnostics->kineticEnergy = kinetic;
+        diagnostics->potentialEnergy = potential;
+        diagnostics->momentumX = momentumX;
+        diagnostics->momentumY = momentumY;
+        diagnostics->bodies = bodies;
+    }
+}
+
+void physicsEffects::assignSubstepLevels(double dt){
+    // Level k means 2^k substeps: the smallest k that keeps travel per substep under
+    // SUBSTEP_TRAVEL_FRACTION of the body's radius.
+    const bool sleeping = sleepSpeed > 0.0;
+    const double floorY = worldHeight.load(std::memory_order_relaxed) - 0.5;
+    size_t slots = static_cast<size_t>(entitySlotEnd());
+    substepLevels.assign(slots, 0);
+    supported.assign(slots, 0);
+    if (restSteps.size() < slots) restSteps.resize(slots, 0);
+    for (Entity *entity : entity_ptr) {
+        if (!entity) continue;
+        size_t id = static_cast<size_t>(entity->get_id());
+        if (id >= substepLevels.size()) {
+            // entities outside the global pool (benchmarks)
+            substepLevels.resize(id + 1, 0);
+            supported.resize(id + 1, 0);
+            restSteps.resize(std::max(restSteps.size(), id + 1), 0);
+        }
+        double speed = std::sqrt(entity->get_vx() * entity->get_vx() + entity->get_vy() * entity->get_vy());
+        double allowed = std::max(1e-3, entity->get_radius() * SUBSTEP_TRAVEL_FRACTION);
+        double ratio = speed * dt / allowed;
+        int level = ratio > 1.0 ? static_cast<int>(std::ceil(std::log2(ratio))) : 0;
+        substepLevels[id] = static_cast<unsigned char>(std::min(level, maxSubstepLevel));
+        unsigned short &rest = restSteps[id];
+        rest = sleeping && speed < sleepSpeed ? static_cast<unsigned short>(std::min(rest + 1, 0xFFFF)) : 0;
+        supported[id] = entity->get_y() + entity->get_radius() >= floorY;
+    }
+    // Bodies touching a fast body (last step's contacts) follow it at the fine rate.
+    for (const contactEvent &event : contacts.getEvents()) {
+        if (event.phase == contactPhase::End) continue;
+        if (!resolveHandle(event.a) || !resolveHandle(event.b)) continue;
+        unsigned char &a = substepLevels[event.a.slot];
+        unsigned char &b = substepLevels[event.b.slot];
+        a = b = std::max(a, b);
+        // Support comes from below: the normal points from b to a and y grows downward.
+        if (event.ny < -0.5f) supported[event.a.slot] = 1;
+        if (event.ny > 0.5f) supported[event.b.slot] = 1;
+    }
+    if (!sleeping) return;
+    // Sleep only while supported (re-checked every step), so a body at the top of its arc or left
+    // hanging when its support moves away never freezes in mid-air.
+    for (Entity *entity : entity_ptr) {
+        if (!entity) continue;
+        size_t id = static_cast<size_t>(entity->get_id());
+        if (restSteps[id] >= SLEEP_STEPS && supported[id]) substepLevels[id] = SLEEPING_LEVEL;
+    }
+}
+
+void physicsEffects::setSleepSpeed(double speed){
+    sleepSpeed = std::max(0.0, speed);
+}
+
+double physicsEffects::getSleepSpeed() const {
+    return sleepSpeed;
+}
+
+int physicsEffects::bodiesAsleep() const {
+    return sleepingBodies;
+}
+
+bool physicsEffects::isSupported(int slot) const {
+    return slot >= 0 && static_cast<size_t>(slot) < supported.size() && supported[slot] != 0;
+}
+
+void physicsEffects::setMaxSubstepLevel(int level){
+    maxSubstepLevel = std::clamp(level, 0, MAX_SUBSTEP_LEVEL);
+}
+
+int physicsEffects::getMaxSubstepLevel() const {
+    return maxSubstepLevel;
+}
+
+int physicsEffects::bodiesAtSubstepLevel(int level) const {
+    return substepHistogram[level];
+}
+
+void physicsEffects::integrate(Entity *entity, double dt, int width, int height){
+    // One (sub)step of dt for a single body.
+    // If entity is on the ground and NOT bouncy, keep it clamped and skip gravity.
+    if (entity->getOnGround() && !entity->getEntityBouncy()) {
+        entity->set_vy(0.0);
+        entity->set_y(height - entity->get_radius());
+        entity->set_x(entity->get_x() + entity->get_vx() * dt);
+        return;
+    }
+    // Gravity is an acceleration (pixels/s^2). Apply per-frame velocity change.
+    entity->addToVy(gravity * dt);
+    if (entity->get_vy() > MAX_FALL_SPEED)
+        entity->set_vy(MAX_FALL_SPEED);
+
+    // Integrate positions using velocity * dt (consistent units)
+    entity->set_y(entity->get_y() + entity->get_vy() * dt);
+    entity->set_x(entity->get_x() + entity->get_vx() * dt);
+
+    // Ground collision handling: clamp to floor and resolve vertical velocity.
+    if (entity->get_y() + entity->get_radius() >= height) {
+        entity->set_y(height - entity->get_radius());
+        // Use weight (mass) to influence bounce response in a stable way.
+        double mass = std::max(1.0, entity->getWeight());
+        // massBounceFactor reduces rebound for heavier objects (tunable constant)
+        const double k = 0.02; // tuning constant
+        double massBounceFactor = 1.0 / (1.0 + (mass - 1.0) * k);
 
-        // Side-wall bounce for bouncy entities
         if (entity->getEntityBouncy()) {
-             int width = GetScreenWidth();
-            if (entity->get_x() + entity->get_radius() >= width || entity->get_x() - entity->get_radius() <= 0) {
-                entity->set_vx(-entity->get_vx() * BOUNCE); // simple horizontal bounce on side walls
+            double preVy = entity->get_vy();
+            double targetVy = -preVy * BOUNCE * massBounceFactor; // mass-scaled rebound
+            if (targetVy < -MAX_FLY_SPEED) {
+                targetVy = -MAX_FLY_SPEED; // clamp upward speed magnitude
+            }
+            entity->set_vy(targetVy); // assign clamped bounce velocity
+            // Only mark bouncy entity as on-ground if bounce is effectively finished
+            if (std::abs(entity->get_vy()) < 0.3) {
+                entity->set_vy(0.0);
+                entity->setOnGround(true);
             }
-            // skip non-bouncy friction logic for bouncy entities
-            continue;
+        } 
+        else {
+            // Non-bouncy: stop downward movement and mark on-ground
+            if (entity->get_vy() > 0.0) {
+                entity->set_vy(0.0);
+            }
+            entity->setOnGround(true);
         }
-        // Apply friction to horizontal velocity; heavier objects decay slower.
-        // Friction constant is per-second retention; per-frame decay = pow(FRICTION, dt / mass)
-        double mass_for_friction = std::max(1.0, entity->getWeight());
-        double decay = std::pow(FRICTION, dt * (1.0 / mass_for_friction));
-        double newVx = entity->get_vx() * decay;
-         if (std::abs(newVx) < 0.01) {
-            newVx = 0.0;
+    }
+
+    // Side-wall bounce for bouncy entities
+    if (entity->getEntityBouncy()) {
+        // Only reflect while moving into the wall, so later substeps don't flip it back outward.
+        if ((entity->get_x() + entity->get_radius() >= width && entity->get_vx() > 0.0) ||
+            (entity->get_x() - entity->get_radius() <= 0 && entity->get_vx() < 0.0)) {
+            entity->set_vx(-entity->get_vx() * BOUNCE); // simple horizontal bounce on side walls
         }
-        entity->set_vx(newVx);
+        // skip non-bouncy friction logic for bouncy entities
+        return;
     }
+    // Apply friction to horizontal velocity; heavier objects decay slower.
+    // Friction constant is per-second retention; per-frame decay = pow(FRICTION, dt / mass)
+    double mass_for_friction = std::max(1.0, entity->getWeight());
+    double decay = std::pow(FRICTION, dt * (1.0 / mass_for_friction));
+    double newVx = entity->get_vx() * decay;
+     if (std::abs(newVx) < 0.01) {
+        newVx = 0.0;
+    }
+    entity->set_vx(newVx);
 }
 
 void physicsEffects::addToEntityList(Entity *entity){
-    for (int i = 0; i < entity_ptr.size(); i++) {
-        if (entity_ptr[i] == entity) {
-            return; // already in list
-        }
-        if (entity_ptr[i] == nullptr) {
-            entity_ptr[i] = entity;
-            return; // added in empty slot
-        }
-    }
-    // If we reach here, no empty slot was found; add to the end
-    entity_ptr.push_back(entity);
+    // Indexed by pool slot (the entity's id): registering is one write, and a reused slot reuses its entry.
+    size_t slot = static_cast<size_t>(entity->get_id());
+    if (slot >= entity_ptr.size()) entity_ptr.resize(slot + 1, nullptr);
+    entity_ptr[slot] = entity;
+    if (slot < restSteps.size()) restSteps[slot] = 0; // a reused slot must not inherit its old rest count
+}
+void physicsEffects::addRangeToEntityList(Entity *const *entities, size_t count){
+    for (size_t i = 0; i < count; ++i) addToEntityList(entities[i]);
 }
 void physicsEffects::removeFromEntityList(Entity *entity){
-    for (size_t i = 0; i < entity_ptr.size(); i++) {
-        if (entity_ptr[i] == entity) {
-            entity_ptr[i] = nullptr; // mark slot as empty
-            return;
-        }
-        if (entity_ptr[i] == nullptr) {
-            continue; // skip empty slots
-        }
+    size_t slot = static_cast<size_t>(entity->get_id());
+    if (slot < entity_ptr.size() && entity_ptr[slot] == entity) {
+        entity_ptr[slot] = nullptr;
+        if (slot < restSteps.size()) restSteps[slot] = 0;
     }
-    entity_ptr.erase(std::remove(entity_ptr.begin(), entity_ptr.end(), entity), entity_ptr.end());
 }
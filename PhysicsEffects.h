@@ -2,27 +2,88 @@
 /**
  * @brief The physicsEffects class applies world forces (gravity), friction and bounce-handling.
  * Notes:
- * - All velocities are stored in pixels/s and updated per-frame using dt = GetFrameTime().
- * - This class holds non-owning Entity pointers.
+ * - All velocities are stored in pixels/s and updated per step using the simulation dt.
+ * - This class holds non-owning Entity pointers, indexed by pool slot (Entity::get_id); free slots are nullptr.
  */
 #ifndef physicsEffects_h
 #define physicsEffects_h
 #include "Entity.h"
+#include "quadTree.h"
+#include "diagnostics.h"
+#include "config.h"
 #include <vector>
 
 class physicsEffects {
     private:
     std::vector<Entity*> entity_ptr;
+    double gravity{GRAVITY}; // uniform downward acceleration (pixels/s^2)
+    std::vector<unsigned char> substepLevels; // per slot: integrate in 2^level substeps this step
+    int maxSubstepLevel{MAX_SUBSTEP_LEVEL};
+    int substepHistogram[MAX_SUBSTEP_LEVEL + 1]{};
+    double sleepSpeed{0.0};                   // bodies slower than this may sleep; 0 disables sleeping
+    std::vector<unsigned short> restSteps;    // per slot: consecutive steps below sleepSpeed (zeroed when the slot is registered or freed)
+    std::vector<unsigned char> supported;     // per slot: on the floor or resting on a body (last step's contacts)
+    int sleepingBodies{0};
+    double mutualPotential{0.0};              // from the last applyMutualGravity, consumed by the next applyGravity
+    void assignSubstepLevels(double dt);
+    void integrate(Entity *entity, double dt, int width, int height);
     public:
     physicsEffects() = default;
 
-    /** Apply gravity, friction and simple bounce resolution once per frame. */
-    void applyGravity();
+    /** Set the uniform downward acceleration; N-body mode sets it to 0. */
+    void setGravity(double g);
 
-    /** Register a non-owning entity pointer for physics updates (duplicates ignored). */
+    /**
+     * Add each registered entity's Barnes–Hut acceleration from `tree` to its velocity (N-body mode).
+     * Runs in parallel; each entity only writes its own velocity. With `measurePotential`, the
+     * pairwise potential energy -sum(G * m_i * m_j / r) is reduced in the same traversal (same
+     * approximation and softening as the force, positions as in `tree`) and reported by the next
+     * applyGravity as part of the potential energy.
+     */
+    void applyMutualGravity(const quadTree &tree, const gravityParams &params, double dt, bool measurePotential = false);
+
+    /**
+     * Apply gravity, friction and simple bounce resolution once per simulation step of `dt` seconds.
+     * Multi-rate: each body gets a power-of-two substep level from its speed relative to its radius
+     * (see SUBSTEP_TRAVEL_FRACTION); bodies in contact with a fast body are raised to its level.
+     * Slow and resting bodies keep a single step. Bodies are integrated in parallel.
+     * When `diagnostics` is non-null, kinetic/potential energy, momentum and the body count are
+     * reduced in the same pass and written into it (other fields are left untouched). The potential
+     * is the uniform field's plus any mutual potential measured by applyMutualGravity this step.
+     */
+    void applyGravity(double dt, stepDiagnostics *diagnostics = nullptr);
+
+    /** Cap on the substep level (0 disables multi-rate stepping); clamped to MAX_SUBSTEP_LEVEL. */
+    void setMaxSubstepLevel(int level);
+    int getMaxSubstepLevel() const;
+
+    /** Number of bodies integrated at `level` during the last applyGravity. */
+    int bodiesAtSubstepLevel(int level) const;
+
+    /**
+     * Sleep threshold in pixels/s. A body slower than this for SLEEP_STEPS consecutive steps while
+     * resting on the floor or on another body skips integration until a collision or input speeds
+     * it up again. 0 (the default) disables sleeping.
+     */
+    void setSleepSpeed(double speed);
+    double getSleepSpeed() const;
+
+    /** Number of bodies that skipped integration (asleep) during the last applyGravity. */
+    int bodiesAsleep() const;
+
+    /**
+     * Whether the body in `slot` rested on the floor or on another body at the start of the last
+     * applyGravity. Input reads this rather than Entity::getOnGround, which the collision pass resets.
+     */
+    bool isSupported(int slot) const;
+
+    /** Register a non-owning entity pointer for physics updates at its slot (O(1); re-registering is a no-op). */
     void addToEntityList(Entity *entity);
 
-    /** Unregister an entity pointer. */
+    /** Register a freshly spawned block of entity pointers. */
+    void addRangeToEntityList(Entity *const *entities, size_t count);
+
+    /** Unregister an entity pointer (O(1): clears its slot). */
     void removeFromEntityList(Entity *entity);
 };
 #endif // physicsEffects_h
\ No newline at end of file
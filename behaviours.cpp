@@ -0,0 +1,115 @@
+// behaviours implementation: coroutine ownership, the wheel-driven scheduler, and the demo behaviours.
+
+#include "behaviours.h"
+#include "commands.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+behaviour::behaviour(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+behaviour::behaviour(behaviour &&other) noexcept : handle(std::exchange(other.handle, {})) {}
+
+behaviour &behaviour::operator=(behaviour &&other) noexcept {
+    if (this != &other) {
+        if (handle) handle.destroy();
+        handle = std::exchange(other.handle, {});
+    }
+    return *this;
+}
+
+behaviour::~behaviour(){
+    if (handle) handle.destroy();
+}
+
+void waitSteps::await_suspend(std::coroutine_handle<behaviour::promise_type> handle) const {
+    handle.promise().scheduler->resumeAfter(handle, steps);
+}
+
+behaviourScheduler::~behaviourScheduler(){
+    clear();
+}
+
+void behaviourScheduler::resumeAfter(std::coroutine_handle<behaviour::promise_type> handle, uint64_t steps){
+    wheel.schedule(steps, handle.address());
+}
+
+void behaviourScheduler::start(behaviour task, uint64_t delaySteps){
+    if (!task.handle) return;
+    std::coroutine_handle<behaviour::promise_type> handle = std::exchange(task.handle, {});
+    handle.promise().scheduler = this;
+    resumeAfter(handle, delaySteps);
+    ++live;
+}
+
+int behaviourScheduler::advance(){
+    auto start = std::chrono::steady_clock::now();
+    lastResumed = wheel.advance([this](void *address) {
+        auto handle = std::coroutine_handle<behaviour::promise_type>::from_address(address);
+        handle.resume(); // runs until its next co_await (which reschedules it) or its end
+        if (handle.done()) {
+            handle.destroy();
+            --live;
+        }
+    });
+    lastMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return lastResumed;
+}
+
+void behaviourScheduler::clear(){
+    wheel.clear([](void *address) { std::coroutine_handle<>::from_address(address).destroy(); });
+    live = 0;
+}
+
+int behaviourScheduler::active() const {
+    return live;
+}
+
+int behaviourScheduler::resumedLastStep() const {
+    return lastResumed;
+}
+
+double behaviourScheduler::lastAdvanceMs() const {
+    return lastMs;
+}
+
+behaviour emitterBehaviour(entityHandle source, int intervalSteps, int count){
+    for (int emitted = 0; count <= 0 || emitted < count; ++emitted) {
+        co_await waitSteps{static_cast<uint64_t>(intervalSteps)};
+        const Entity *entity = resolveHandle(source);
+        if (!entity) co_return;
+        const double radius = MIN_RADIUS;
+        // Debris: collides with the scene but not with the player (the player's mask is set in main(), right after initializePlayers).
+        entityCommand command = entityCommand::spawn(entity->get_x(), entity->get_y() - entity->get_radius() - radius - 1.0,
+                                                     radius, 1.0, entity->get_color());
+        command.layer = LAYER_DEBRIS;
+        entityCommands.push(command);
+    }
+}
+
+behaviour despawnBehaviour(entityHandle target, int delaySteps){
+    co_await waitSteps{static_cast<uint64_t>(delaySteps)};
+    entityCommands.push(entityCommand::remove(target)); // a stale handle is skipped by the drain
+}
+
+behaviour patrolBehaviour(entityHandle target, double range, double speed){
+    const Entity *entity = resolveHandle(target);
+    if (!entity) co_return;
+    const double left = entity->get_x() - range * 0.5;
+    const double right = entity->get_x() + range * 0.5;
+    double direction = 1.0;
+    for (;;) {
+        entity = resolveHandle(target);
+        if (!entity) co_return;
+        if ((direction > 0.0 && entity->get_x() >= right) || (direction < 0.0 && entity->get_x() <= left)) {
+            direction = -direction;
+        }
+        // Top the horizontal velocity back up every few steps; friction and collisions wear it down in
+        // between. An impulse (delta-v times the mass the drain divides by) adds to other producers'
+        // impulses in the same drain, where a SetVelocity would overwrite them.
+        const double mass = std::max(1.0, entity->getWeight());
+        entityCommands.push(entityCommand::impulse(target, (direction * speed - entity->get_vx()) * mass, 0.0));
+        co_await waitSteps{PATROL_STEER_STEPS};
+    }
+}
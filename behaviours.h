@@ -0,0 +1,91 @@
+// behaviours: scripted entity behaviours written as C++20 coroutines and resumed by a timer wheel.
+/**
+ * @brief A behaviour is a coroutine returning `behaviour` that waits with `co_await waitSteps{n}`.
+ * - behaviourScheduler::start() takes ownership and parks it on a timerWheel; advance() (once per
+ *   step, simulation thread) resumes only the behaviours due on that step, so idle behaviours cost
+ *   nothing however many entities exist.
+ * - Behaviours act on entities by handle and mutate them through entityCommands, like input does;
+ *   a behaviour whose entity is gone should simply co_return. A finished coroutine is destroyed by
+ *   the scheduler.
+ * - Behaviours are not part of the rewind history; they do not advance while rewinding.
+ */
+#ifndef behaviours_h
+#define behaviours_h
+#include "Entity.h"
+#include "timerWheel.h"
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+
+class behaviourScheduler;
+
+/** Coroutine handle owner; created suspended and handed to behaviourScheduler::start(). */
+class behaviour {
+    public:
+    struct promise_type {
+        behaviourScheduler *scheduler{nullptr};
+        behaviour get_return_object() { return behaviour(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+    behaviour(behaviour &&other) noexcept;
+    behaviour &operator=(behaviour &&other) noexcept;
+    behaviour(const behaviour &) = delete;
+    behaviour &operator=(const behaviour &) = delete;
+    ~behaviour(); ///< destroys the coroutine if it was never started
+    private:
+    friend class behaviourScheduler;
+    explicit behaviour(std::coroutine_handle<promise_type> handle);
+    std::coroutine_handle<promise_type> handle;
+};
+
+/** `co_await waitSteps{n}` inside a behaviour: resume n simulation steps later (at least one). */
+struct waitSteps {
+    uint64_t steps;
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<behaviour::promise_type> handle) const;
+    void await_resume() const noexcept {}
+};
+
+class behaviourScheduler {
+    private:
+    timerWheel wheel;
+    int live{0};
+    int lastResumed{0};
+    double lastMs{0.0};
+    friend struct waitSteps;
+    void resumeAfter(std::coroutine_handle<behaviour::promise_type> handle, uint64_t steps);
+    public:
+    behaviourScheduler() = default;
+    behaviourScheduler(const behaviourScheduler &) = delete;
+    behaviourScheduler &operator=(const behaviourScheduler &) = delete;
+    ~behaviourScheduler();
+
+    /** Take ownership of `task` and run it for the first time `delaySteps` steps from now. */
+    void start(behaviour task, uint64_t delaySteps = 1);
+
+    /** One step: resume every behaviour due now. Returns the number resumed. */
+    int advance();
+
+    /** Destroy every pending behaviour. */
+    void clear();
+
+    /** Behaviours started and not yet finished. */
+    int active() const;
+    /** Resumed by the last advance(), and its wall time. */
+    int resumedLastStep() const;
+    double lastAdvanceMs() const;
+};
+
+// Behaviours used by the demo (implemented in behaviours.cpp). Each ends when its entity is released.
+
+/** Every `intervalSteps`, spawn a small body just above `source`; stops after `count` (0 = forever). */
+behaviour emitterBehaviour(entityHandle source, int intervalSteps, int count);
+/** Release `target` after `delaySteps`. */
+behaviour despawnBehaviour(entityHandle target, int delaySteps);
+/** Drive `target` back and forth over `range` pixels centred on where it starts, at `speed` pixels/s.
+ *  Steering is an impulse, so input and other behaviours on the same body still add to it. */
+behaviour patrolBehaviour(entityHandle target, double range, double speed);
+#endif // behaviours_h
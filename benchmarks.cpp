@@ -0,0 +1,770 @@
+// benchmarks implementation: each benchmark builds its own synthetic scene so it never touches `players`
+// (except `commands`, which measures the real drain against the global pool).
+
+#include "benchmarks.h"
+#include "quadTree.h"
+#include "physicsEffects.h"
+#include "commands.h"
+#include "hierarchicalGrid.h"
+#include "parallel.h"
+#include "stateExport.h"
+#include "commandQueue.h"
+#include "rewindHistory.h"
+#include "behaviours.h"
+#include "config.h"
+#include "raylib.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using benchClock = std::chrono::steady_clock;
+void (*simulationStep)(double dt) = nullptr; // the demo's step, set by runBenchmarks
+
+double elapsedMs(benchClock::time_point since){
+    return std::chrono::duration<double, std::milli>(benchClock::now() - since).count();
+}
+
+std::vector<quadItem> randomItems(int n, unsigned seed, float minRadius, float maxRadius,
+                                  float width = 2560.0f, float height = 1300.0f){
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> px(0.0f, width), py(0.0f, height);
+    std::uniform_real_distribution<float> pr(minRadius, maxRadius), pm(1.0f, 100.0f);
+    std::vector<quadItem> items(n);
+    for (int i = 0; i < n; ++i) items[i] = quadItem{px(rng), py(rng), pr(rng), pm(rng), i};
+    return items;
+}
+
+void bruteGravity(const std::vector<quadItem> &items, int self, const gravityParams &params, double &ax, double &ay){
+    ax = ay = 0.0;
+    const quadItem &a = items[self];
+    for (size_t j = 0; j < items.size(); ++j) {
+        if (static_cast<int>(j) == self) continue;
+        double dx = items[j].x - a.x, dy = items[j].y - a.y;
+        double r2 = dx * dx + dy * dy + params.softening;
+        double inv = params.G * items[j].mass / (r2 * std::sqrt(r2));
+        ax += inv * dx;
+        ay += inv * dy;
+    }
+}
+
+// Barnes–Hut vs direct summation: accuracy as a function of theta, then scaling with n.
+void benchNbody(){
+    gravityParams params{static_cast<float>(NBODY_THETA), static_cast<float>(NBODY_G), static_cast<float>(NBODY_SOFTENING)};
+
+    std::printf("== nbody: accuracy vs theta (n=20000, 500 sampled bodies, relative RMS error vs brute force)\n");
+    const int n = 20000, samples = 500;
+    std::vector<quadItem> items = randomItems(n, 1234, 5.0f, 5.0f);
+    quadTree tree;
+    tree.build(items.data(), n);
+    std::vector<double> exactX(samples), exactY(samples);
+    auto start = benchClock::now();
+    for (int s = 0; s < samples; ++s) bruteGravity(items, s * (n / samples), params, exactX[s], exactY[s]);
+    double bruteUsPerBody = elapsedMs(start) * 1000.0 / samples;
+    std::printf("  brute force: %.2f us/body\n", bruteUsPerBody);
+    std::printf("  %6s %14s %12s %10s\n", "theta", "rms rel err", "us/body", "speedup");
+    for (float theta : {0.1f, 0.2f, 0.3f, 0.5f, 0.7f, 1.0f}) {
+        params.theta = theta;
+        double err2 = 0.0, ref2 = 0.0;
+        start = benchClock::now();
+        for (int s = 0; s < samples; ++s) {
+            const quadItem &a = items[s * (n / samples)];
+            double ax, ay;
+            tree.gravityAt(a.x, a.y, a.slot, params, ax, ay);
+            err2 += (ax - exactX[s]) * (ax - exactX[s]) + (ay - exactY[s]) * (ay - exactY[s]);
+            ref2 += exactX[s] * exactX[s] + exactY[s] * exactY[s];
+        }
+        double usPerBody = elapsedMs(start) * 1000.0 / samples;
+        std::printf("  %6.2f %14.2e %12.2f %9.1fx\n", theta, std::sqrt(err2 / ref2), usPerBody, bruteUsPerBody / usPerBody);
+    }
+
+    std::printf("== nbody: scaling (theta=%.2f, %d workers; brute force extrapolated from 200 bodies)\n",
+                NBODY_THETA, parallelWorkerCount());
+    std::printf("  %8s %10s %12s %14s %16s\n", "n", "build ms", "force ms", "ns/(n log2 n)", "brute est. ms");
+    params.theta = static_cast<float>(NBODY_THETA);
+    for (int count : {1000, 10000, 100000, 300000}) {
+        items = randomItems(count, 99, 5.0f, 5.0f);
+        start = benchClock::now();
+        tree.build(items.data(), count);
+        double buildMs = elapsedMs(start);
+        start = benchClock::now();
+        std::vector<float> out(static_cast<size_t>(count) * 2);
+        parallelFor(count, 1024, [&](int begin, int end, int) {
+            for (int i = begin; i < end; ++i) {
+                double ax, ay;
+                tree.gravityAt(items[i].x, items[i].y, items[i].slot, params, ax, ay);
+                out[2 * i] = static_cast<float>(ax);
+                out[2 * i + 1] = static_cast<float>(ay);
+            }
+        });
+        double forceMs = elapsedMs(start);
+        start = benchClock::now();
+        for (int s = 0; s < 200; ++s) {
+            double ax, ay;
+            bruteGravity(items, s * (count / 200), params, ax, ay);
+        }
+        double bruteMs = elapsedMs(start) / 200.0 * count;
+        double nlogn = count * std::log2(static_cast<double>(count));
+        std::printf("  %8d %10.2f %12.2f %14.2f %16.0f\n", count, buildMs, forceMs,
+                    (buildMs + forceMs) * 1e6 / nlogn, bruteMs);
+    }
+}
+
+// Query throughput against a 1M-entity tree; every query writes into one reused buffer.
+// The world is scaled up (about one body per 200 px^2) so the scene is crowded but not a solid pile.
+void benchQueries(){
+    const int n = 1000000, queries = 200000;
+    const float width = 20000.0f, height = 10000.0f;
+    std::vector<quadItem> items = randomItems(n, 7, static_cast<float>(MIN_RADIUS), 10.0f, width, height);
+    quadTree tree;
+    auto start = benchClock::now();
+    tree.build(items.data(), n);
+    std::printf("== queries: n=%d in %.0fx%.0f, build %.1f ms, %d queries each\n", n, width, height, elapsedMs(start), queries);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> px(0.0f, width), py(0.0f, height), angle(0.0f, 6.2831853f);
+    std::vector<int> buffer(4096);
+    long long checksum = 0; // keeps the optimizer from dropping the loops
+    auto report = [&](const char *label, double ms, long long results) {
+        std::printf("  %-22s %8.1f ms %10.2f Mq/s %10.1f results/query\n", label, ms,
+                    queries / (ms * 1000.0), static_cast<double>(results) / queries);
+    };
+
+    start = benchClock::now();
+    long long results = 0;
+    for (int q = 0; q < queries; ++q) results += tree.queryRadius(px(rng), py(rng), 30.0f, buffer.data(), 4096);
+    report("radius r=30", elapsedMs(start), results);
+    checksum += results;
+
+    start = benchClock::now();
+    results = 0;
+    for (int q = 0; q < queries; ++q) {
+        float x = px(rng), y = py(rng);
+        results += tree.queryBox(x, y, x + 60.0f, y + 40.0f, buffer.data(), 4096);
+    }
+    report("box 60x40", elapsedMs(start), results);
+    checksum += results;
+
+    start = benchClock::now();
+    results = 0;
+    for (int q = 0; q < queries; ++q) {
+        float a = angle(rng);
+        float hit = 0.0f;
+        results += tree.raycast(px(rng), py(rng), std::cos(a), std::sin(a), 3000.0f, &hit) >= 0 ? 1 : 0;
+    }
+    report("raycast (hit rate)", elapsedMs(start), results);
+    checksum += results;
+
+    start = benchClock::now();
+    results = 0;
+    for (int q = 0; q < queries; ++q) results += tree.pick(px(rng), py(rng)) >= 0 ? 1 : 0;
+    report("point pick (hit rate)", elapsedMs(start), results);
+    checksum += results;
+    std::printf("  checksum %lld\n", checksum);
+}
+
+// The original DetectCollison loop: every pair, AABB reject, then the circle test.
+long long bruteForcePairs(const std::vector<quadItem> &items){
+    long long touching = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const quadItem &a = items[i];
+        for (size_t j = i + 1; j < items.size(); ++j) {
+            const quadItem &b = items[j];
+            if (a.x + a.radius < b.x - b.radius || a.x - a.radius > b.x + b.radius ||
+                a.y + a.radius < b.y - b.radius || a.y - a.radius > b.y + b.radius) {
+                continue;
+            }
+            float dx = a.x - b.x, dy = a.y - b.y, reach = a.radius + b.radius;
+            if (dx * dx + dy * dy <= reach * reach) ++touching;
+        }
+    }
+    return touching;
+}
+
+// Mixed-radius scenes: brute force vs quadtree pairs vs hierarchical grid (build + pair pass, touching pairs counted).
+void benchBroadphase(){
+    struct scene {
+        const char *name;
+        float smallShare; // fraction drawn from [MIN_RADIUS, 10], the rest from [10, MAX_RADIUS]
+    };
+    const scene scenes[] = {{"uniform small", 1.0f}, {"90% small / 10% large", 0.9f}, {"50/50", 0.5f}};
+    std::printf("== broadphase: mixed radii %.0f..%.0f, ~1200 px^2 of world per body\n", MIN_RADIUS, MAX_RADIUS);
+    std::printf("  %-22s %7s %11s %11s %11s %9s %6s\n", "scene", "n", "brute ms", "quadtree ms", "hgrid ms", "touching", "levels");
+    for (const scene &sc : scenes) {
+        for (int n : {2000, 10000, 100000}) {
+            float side = std::sqrt(1200.0f * n);
+            std::mt19937 rng(n);
+            std::uniform_real_distribution<float> pos(0.0f, side), unit(0.0f, 1.0f);
+            std::uniform_real_distribution<float> small(static_cast<float>(MIN_RADIUS), 10.0f);
+            std::uniform_real_distribution<float> large(10.0f, static_cast<float>(MAX_RADIUS));
+            std::vector<quadItem> items(n);
+            for (int i = 0; i < n; ++i) {
+                float r = unit(rng) < sc.smallShare ? small(rng) : large(rng);
+                items[i] = quadItem{pos(rng), pos(rng), r, 1.0f, i};
+            }
+            auto countTouching = [&](int a, int b) {
+                const quadItem &p = items[a], &q = items[b];
+                float dx = p.x - q.x, dy = p.y - q.y, reach = p.radius + q.radius;
+                return dx * dx + dy * dy <= reach * reach ? 1 : 0;
+            };
+
+            double bruteMs = -1.0;
+            long long bruteTouching = -1;
+            if (n <= 10000) { // quadratic; skipped where it would dominate the run
+                auto start = benchClock::now();
+                bruteTouching = bruteForcePairs(items);
+                bruteMs = elapsedMs(start);
+            }
+
+            quadTree tree;
+            long long treeTouching = 0;
+            auto start = benchClock::now();
+            tree.build(items.data(), n);
+            tree.forEachCandidatePair([&](int a, int b) { treeTouching += countTouching(a, b); });
+            double treeMs = elapsedMs(start);
+
+            hierarchicalGrid grid;
+            long long gridTouching = 0;
+            start = benchClock::now();
+            grid.build(items.data(), n);
+            grid.forEachCandidatePair([&](int a, int b) { gridTouching += countTouching(a, b); });
+            double gridMs = elapsedMs(start);
+
+            bool agree = treeTouching == gridTouching && (bruteTouching < 0 || bruteTouching == gridTouching);
+            std::printf("  %-22s %7d %11s %11.2f %11.2f %9lld %6d%s\n", sc.name, n,
+                        bruteMs < 0 ? "-" : TextFormat("%.2f", bruteMs), treeMs, gridMs, gridTouching,
+                        grid.levelCount(), agree ? "" : "  MISMATCH");
+        }
+    }
+}
+
+// Cost of the fused diagnostics reduction: the integration pass over 1M bodies with and without it.
+// Uses a private physicsEffects and entity array; only the world size globals are touched.
+void benchDiagnostics(){
+    const int n = 1000000, reps = 20;
+    worldWidth = 20000;
+    worldHeight = 10000;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> px(0.0, 20000.0), py(0.0, 9000.0), pv(-50.0, 50.0), pw(1.0, 100.0);
+    std::vector<Entity> bodies(n);
+    std::vector<Entity*> pointers(n);
+    for (int i = 0; i < n; ++i) {
+        bodies[i] = Entity("", px(rng), py(rng), 0, 5.0, pw(rng), RED);
+        bodies[i].set_id(i);
+        bodies[i].setVelocity(pv(rng), pv(rng));
+        pointers[i] = &bodies[i];
+    }
+    physicsEffects local;
+    local.addRangeToEntityList(pointers.data(), pointers.size());
+    const double dt = 1.0 / SIM_STEP_HZ;
+    local.applyGravity(dt); // warm up
+
+    // Alternate the two variants so drift in the scene affects both equally.
+    double plainMs = 0.0, measuredMs = 0.0;
+    stepDiagnostics diagnostics;
+    for (int r = 0; r < reps; ++r) {
+        auto start = benchClock::now();
+        local.applyGravity(dt);
+        plainMs += elapsedMs(start);
+        start = benchClock::now();
+        local.applyGravity(dt, &diagnostics);
+        measuredMs += elapsedMs(start);
+    }
+    plainMs /= reps;
+    measuredMs /= reps;
+    std::printf("== diagnostics: integration pass, n=%d, %d workers\n", n, parallelWorkerCount());
+    std::printf("  without %.2f ms, with %.2f ms, overhead %.1f%%\n", plainMs, measuredMs,
+                (measuredMs - plainMs) / plainMs * 100.0);
+    std::printf("  last: kinetic %.4g potential %.4g momentum (%.4g, %.4g) bodies %d\n", diagnostics.kineticEnergy,
+                diagnostics.potentialEnergy, diagnostics.momentumX, diagnostics.momentumY, diagnostics.bodies);
+}
+
+// Producer-to-consumer delay of the shared-memory export. A producer publishes synthetic frames at
+// SIM_STEP_HZ through stateWriter; a consumer thread with its own read-only mapping of the region (the
+// same path an external process takes) polls for new frames, reads each one in place and validates it.
+void benchExport(){
+    const char *region = "physics_demo_bench";
+    const int frames = SIM_STEP_HZ * 2;
+    std::printf("== export: %d frames at %d Hz per row, consumer on a separate read-only mapping\n", frames, SIM_STEP_HZ);
+    std::printf("  %8s %11s %11s %11s %11s %10s %6s %7s\n", "n", "publish ms", "p50 us", "p99 us", "max us",
+                "read ms", "torn", "missed");
+    for (int n : {1000, 10000, 100000, 1000000}) {
+        stateWriter writer;
+        stateReader reader;
+        if (!writer.open(region, static_cast<uint32_t>(n)) || !reader.open(region)) {
+            std::printf("  could not create or map shared memory region '%s'\n", region);
+            return;
+        }
+        std::vector<quadItem> items = randomItems(n, 11, 5.0f, 5.0f);
+
+        std::atomic<bool> done{false};
+        std::vector<double> latencyUs;
+        latencyUs.reserve(frames);
+        double readMs = 0.0;
+        int torn = 0;
+        std::thread consumer([&]() {
+            uint64_t last = 0;
+            volatile float sink = 0.0f;
+            while (!done.load(std::memory_order_acquire)) {
+                uint64_t published = reader.published();
+                if (published == last) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                last = published;
+                int64_t seenNs = exportClockNs();
+                stateFrameView view;
+                if (!reader.latest(view)) continue;
+                latencyUs.push_back((seenNs - view.publishNs) / 1000.0);
+                auto start = benchClock::now();
+                float sum = 0.0f;
+                for (uint32_t i = 0; i < view.count; ++i) sum += view.x[i] + view.vy[i];
+                bool consistent = reader.validate(view);
+                readMs += elapsedMs(start);
+                if (!consistent) ++torn;
+                sink = sum;
+            }
+            (void)sink;
+        });
+
+        const auto period = std::chrono::duration_cast<benchClock::duration>(std::chrono::duration<double>(1.0 / SIM_STEP_HZ));
+        auto next = benchClock::now();
+        double publishMs = 0.0;
+        for (int frame = 0; frame < frames; ++frame) {
+            auto start = benchClock::now();
+            exportFrameArrays out = writer.beginFrame();
+            for (int i = 0; i < n; ++i) {
+                out.x[i] = items[i].x + frame;
+                out.y[i] = items[i].y;
+                out.vx[i] = 1.0f;
+                out.vy[i] = static_cast<float>(frame);
+                out.radius[i] = items[i].radius;
+                out.flags[i] = EXPORT_BOUNCY;
+                out.slot[i] = i;
+            }
+            writer.publish(static_cast<uint32_t>(n), static_cast<uint64_t>(frame));
+            if (frame >= 2) publishMs += elapsedMs(start); // the first write to each slot pays its page faults
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+        done.store(true, std::memory_order_release);
+        consumer.join();
+
+        std::sort(latencyUs.begin(), latencyUs.end());
+        size_t seen = latencyUs.size();
+        auto percentile = [&](double p) { return seen ? latencyUs[std::min(seen - 1, static_cast<size_t>(p * seen))] : 0.0; };
+        std::printf("  %8d %11.3f %11.1f %11.1f %11.1f %10.3f %6d %7d\n", n, publishMs / (frames - 2), percentile(0.5),
+                    percentile(0.99), seen ? latencyUs.back() : 0.0, seen ? readMs / seen : 0.0, torn,
+                    frames - static_cast<int>(seen));
+    }
+}
+
+// Ingest and apply throughput of the entity command path. Producers push a mix of set-velocity,
+// impulse, resize, delete and spawn commands into the global entityCommands; the consumer runs the
+// real drainEntityCommands at SIM_STEP_HZ against the global pool, populated with `bodies` entities
+// (deletes and spawns are balanced, so the pool stays near that size). The only benchmark that
+// touches `players`; the pool is released again at the end.
+void benchCommands(){
+    const int bodies = 1000000;
+    const auto duration = std::chrono::milliseconds(1000);
+    worldWidth = 20000;
+    worldHeight = 10000;
+    spawnParams params;
+    params.x = {0.0, 20000.0};
+    params.y = {0.0, 10000.0};
+    SpawnEntities(bodies, params);
+    auto makeCommand = [&](uint32_t n) {
+        // Slot-addressed like the feeder: deletes and respawns make generation-checked handles go stale.
+        entityHandle target{static_cast<int>((n * 2654435761u) % bodies), COMMAND_ANY_GENERATION};
+        switch (n % 5) {
+            case 0: return entityCommand::setVelocity(target, 1.0, -1.0);
+            case 1: return entityCommand::impulse(target, 5.0, 5.0);
+            case 2: return entityCommand::resize(target, 6.0);
+            case 3: return entityCommand::remove(target);
+            default: return entityCommand::spawn(100.0, 100.0, 5.0, 1.0, RED);
+        }
+    };
+
+    std::printf("== commands: queue capacity %d, drained at %d Hz for 1 s, pool of %d, mix setvel/impulse/resize/delete/spawn\n",
+                COMMAND_QUEUE_CAPACITY, SIM_STEP_HZ, bodies);
+    std::printf("  %-24s %12s %12s %10s %10s %10s %10s\n", "producers", "offered/s", "applied/s", "max depth",
+                "drain ms", "ns/cmd", "dropped");
+    // `feed(queue, stop)` runs the producers until `stop` is set and returns the number of commands offered.
+    auto runRow = [&](const char *label, auto feed) {
+        commandQueue &queue = entityCommands;
+        const uint64_t droppedBefore = queue.droppedCount();
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> offered{0};
+        std::thread producers([&]() { offered = feed(queue, stop); });
+        const auto period = std::chrono::duration_cast<benchClock::duration>(std::chrono::duration<double>(1.0 / SIM_STEP_HZ));
+        auto begin = benchClock::now(), next = begin;
+        uint64_t applied = 0;
+        size_t maxDepth = 0;
+        double drainMs = 0.0;
+        int drains = 0;
+        while (benchClock::now() - begin < duration) {
+            next += period;
+            std::this_thread::sleep_until(next);
+            maxDepth = std::max(maxDepth, queue.depth());
+            auto start = benchClock::now();
+            applied += static_cast<uint64_t>(drainEntityCommands());
+            drainMs += elapsedMs(start);
+            ++drains;
+        }
+        stop = true;
+        producers.join();
+        applied += static_cast<uint64_t>(drainEntityCommands());
+        double seconds = elapsedMs(begin) / 1000.0;
+        std::printf("  %-24s %12.0f %12.0f %10zu %10.3f %10.1f %10llu\n", label, offered / seconds, applied / seconds,
+                    maxDepth, drainMs / drains, applied ? drainMs * 1e6 / applied : 0.0,
+                    static_cast<unsigned long long>(queue.droppedCount() - droppedBefore));
+    };
+    // Threads pushing at a fixed total rate (a load generator) or as fast as they can (flood).
+    auto threadFeed = [&](int threads, double ratePerThread) {
+        return [&, threads, ratePerThread](commandQueue &queue, std::atomic<bool> &stop) {
+            std::atomic<uint64_t> offered{0};
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() {
+                    auto start = benchClock::now();
+                    uint32_t n = static_cast<uint32_t>(t) * 7919u;
+                    uint64_t sent = 0;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        queue.push(makeCommand(n++));
+                        ++sent;
+                        if (ratePerThread > 0.0 && sent % 64 == 0) {
+                            std::this_thread::sleep_until(start + std::chrono::duration_cast<benchClock::duration>(
+                                                                      std::chrono::duration<double>(sent / ratePerThread)));
+                        }
+                    }
+                    offered += sent;
+                });
+            }
+            for (std::thread &worker : workers) worker.join();
+            return offered.load();
+        };
+    };
+    runRow("1 thread, 10k/s", threadFeed(1, 10000.0));
+    runRow("4 threads, 10k/s each", threadFeed(4, 10000.0));
+    runRow("1 thread, flood", threadFeed(1, 0.0));
+    runRow("4 threads, flood", threadFeed(4, 0.0));
+#ifndef _WIN32
+    // Same path as --listen: a client streams text lines into a commandFeeder socket.
+    const char *path = "/tmp/physics_demo_bench.sock";
+    runRow("unix socket, flood", [&](commandQueue &queue, std::atomic<bool> &stop) {
+        commandFeeder feeder(queue);
+        if (!feeder.start(path)) return uint64_t{0};
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, path);
+        uint64_t sent = 0;
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0) {
+            std::string batch;
+            uint32_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                batch.clear();
+                for (int i = 0; i < 128; ++i, ++n) {
+                    // Same mix as the threads, as text.
+                    static const char *const lines[] = {"setvel %d 1 -1\n", "impulse %d 5 5\n", "resize %d 6\n",
+                                                        "delete %d\n", "spawn 100 100 5 1 %d\n"};
+                    const int slot = static_cast<int>((n * 2654435761u) % bodies);
+                    batch += n % 5 == 4 ? TextFormat(lines[4], 1) : TextFormat(lines[n % 5], slot);
+                }
+                if (write(fd, batch.data(), batch.size()) < 0) break;
+                sent += 128;
+            }
+        }
+        if (fd >= 0) close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // let the feeder push what it has read
+        feeder.stop();
+        return sent;
+    });
+#endif
+    for (int slot = 0; slot < entitySlotEnd(); ++slot) releaseEntity(slot);
+}
+
+// Rewind history on a private pool: bytes per recorded step, recording cost, and restore cost when
+// a given share of the bodies moves each step (a settled pile moves almost none). Moved bodies are
+// reported with markChanged, as the integrator does; "diff all" is the cost when every slot is reported.
+void benchHistory(){
+    const int n = 100000;
+    const int steps = 2400;
+    std::printf("== history: %d bodies, %d steps, keyframe every %d steps at most, budget %d MB\n", n, steps,
+                HISTORY_KEYFRAME_INTERVAL, HISTORY_MEMORY_MB);
+    std::printf("  %-8s %10s %10s %10s %10s %12s %10s %10s %10s\n", "moving", "KB/step", "record ms", "diff all",
+                "window", "keyframes", "seek ms", "back 1 ms", "fwd 1 ms");
+    for (double share : {0.001, 0.01, 0.1, 1.0}) {
+        std::vector<Entity> storage(n, Entity("", 0.0, 0.0, 0, 5.0, 10.0, RED));
+        std::vector<Entity*> slots(n);
+        for (int i = 0; i < n; ++i) {
+            storage[i].set_x(i % 2000);
+            storage[i].set_y(i / 2000 * 10.0);
+            slots[i] = &storage[i];
+        }
+        historyPool pool{&slots, [&]() { return n; },
+                         [&](const std::vector<int> &revive) { for (int slot : revive) slots[slot] = &storage[slot]; },
+                         [&](int slot) { slots[slot] = nullptr; }};
+        rewindHistory history(pool, static_cast<size_t>(HISTORY_MEMORY_MB) << 20, HISTORY_KEYFRAME_INTERVAL, n);
+        rewindHistory diffAll(pool, static_cast<size_t>(HISTORY_MEMORY_MB) << 20, HISTORY_KEYFRAME_INTERVAL, n);
+        // Every body moves once per `stride` steps, so `share` of them change in each step.
+        const int stride = std::max(1, static_cast<int>(std::lround(1.0 / share)));
+        double recordMs = 0.0, diffAllMs = 0.0;
+        for (int step = 1; step <= steps; ++step) {
+            for (int i = step % stride; i < n; i += stride) {
+                storage[i].set_x(storage[i].get_x() + 0.5);
+                storage[i].set_vx(30.0);
+                history.markChanged(i);
+            }
+            auto start = benchClock::now();
+            history.record(step);
+            recordMs += elapsedMs(start);
+            for (int i = 0; i < n; ++i) diffAll.markChanged(i);
+            start = benchClock::now();
+            diffAll.record(step);
+            diffAllMs += elapsedMs(start);
+        }
+        diffAll.clear();
+        const int window = history.frameCount();
+        const int keyframes = history.keyframeCount();
+        const double kbPerStep = history.memoryBytes() / 1024.0 / std::max(1, window);
+        history.begin();
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<int> pick(0, history.frameCount() - 1);
+        double seekMs = 0.0;
+        const int seeks = 50;
+        for (int i = 0; i < seeks; ++i) {
+            history.seek(pick(rng));
+            seekMs += history.lastSeekMillis();
+        }
+        // Scrubbing: a step back replays from the keyframe, a step forward applies one delta.
+        double backMs = 0.0, forwardMs = 0.0;
+        const int scrubs = 20;
+        int offset = history.frameCount() / 2;
+        history.seek(offset);
+        for (int i = 0; i < scrubs; ++i) {
+            history.seek(++offset);
+            backMs += history.lastSeekMillis();
+        }
+        for (int i = 0; i < scrubs; ++i) {
+            history.seek(--offset);
+            forwardMs += history.lastSeekMillis();
+        }
+        std::printf("  %7.1f%% %10.1f %10.3f %10.3f %10d %12d %10.3f %10.3f %10.3f\n", share * 100.0, kbPerStep,
+                    recordMs / steps, diffAllMs / steps, window, keyframes, seekMs / seeks, backMs / scrubs, forwardMs / scrubs);
+    }
+
+    // The same on a real resting pile: the demo's full step (stepHistory records inside it), so the
+    // reported slots are whatever the integrator, solver, bounds and contact passes mark.
+    if (!simulationStep) return;
+    const int pile = 10000;
+    const int settleSteps = 2400, measureSteps = 240;
+    worldWidth = 1000;
+    worldHeight = 1000;
+    budgetEnabled = false; // knobs stay put; the sleep speed is set per row below
+    historyEnabled = true;
+    std::printf("== history on a resting pile: %d bodies, %d steps to settle, %d measured (full step)\n", pile,
+                settleSteps, measureSteps);
+    std::printf("  %-12s %10s %12s %10s %10s\n", "sleep px/s", "asleep", "reported", "KB/step", "record ms");
+    for (double sleepSpeed : {0.0, SLEEP_SPEED_MAX}) {
+        spawnParams params;
+        params.x = {10.0, 990.0};
+        params.y = {10.0, 990.0};
+        params.radius = {4.0, 4.0};
+        SpawnEntities(pile, params);
+        physics.setSleepSpeed(sleepSpeed);
+        const double dt = 1.0 / SIM_STEP_HZ;
+        for (int step = 0; step < settleSteps; ++step) simulationStep(dt);
+        stepHistory.clear(); // measure from a keyframe, well inside the memory budget (no eviction)
+        double recordMs = 0.0;
+        long long reported = 0;
+        for (int step = 0; step < measureSteps; ++step) {
+            simulationStep(dt);
+            recordMs += stepHistory.lastRecordMillis();
+            reported += stepHistory.lastRecordReported();
+        }
+        const double kbPerStep = stepHistory.memoryBytes() / 1024.0 / std::max(1, stepHistory.frameCount());
+        std::printf("  %-12.0f %10d %12.0f %10.1f %10.3f\n", sleepSpeed, physics.bodiesAsleep(),
+                    static_cast<double>(reported) / measureSteps, kbPerStep, recordMs / measureSteps);
+        for (int slot = 0; slot < entitySlotEnd(); ++slot) releaseEntity(slot);
+        stepHistory.clear();
+    }
+}
+
+behaviour benchTicker(uint64_t period, uint64_t &fired){
+    for (;;) {
+        ++fired;
+        co_await waitSteps{period};
+    }
+}
+
+// Scheduled behaviours: 100k coroutines on a private scheduler with various periods, against the
+// alternative of polling a countdown per behaviour every step.
+void benchBehaviours(){
+    const int n = 100000;
+    const int steps = 2400;
+    std::printf("== behaviours: %d coroutines, %d steps, %d-level timer wheel\n", n, steps, timerWheel::LEVELS);
+    std::printf("  %-22s %10s %12s %12s %14s\n", "periods (steps)", "due/step", "wheel us", "ns/resume", "polling us");
+    auto runRow = [&](const char *label, auto periodOf) {
+        std::mt19937 rng(11);
+        std::vector<uint64_t> periods(n), phases(n);
+        for (int i = 0; i < n; ++i) {
+            periods[i] = periodOf(rng);
+            // Random first resume within one period, so the load is spread like a running scene.
+            phases[i] = std::uniform_int_distribution<uint64_t>(1, periods[i])(rng);
+        }
+        uint64_t fired = 0;
+        behaviourScheduler scheduler;
+        for (int i = 0; i < n; ++i) scheduler.start(benchTicker(periods[i], fired), phases[i]);
+        uint64_t resumed = 0;
+        auto start = benchClock::now();
+        for (int step = 0; step < steps; ++step) resumed += static_cast<uint64_t>(scheduler.advance());
+        double wheelMs = elapsedMs(start);
+
+        // Polling baseline: every behaviour's countdown is visited every step.
+        std::vector<uint64_t> remaining(phases);
+        uint64_t polled = 0;
+        start = benchClock::now();
+        for (int step = 0; step < steps; ++step) {
+            for (int i = 0; i < n; ++i) {
+                if (--remaining[i] == 0) {
+                    remaining[i] = periods[i];
+                    ++polled;
+                }
+            }
+        }
+        double pollMs = elapsedMs(start);
+        std::printf("  %-22s %10.1f %12.1f %12.1f %14.1f\n", label, static_cast<double>(resumed) / steps,
+                    wheelMs * 1000.0 / steps, resumed ? wheelMs * 1e6 / resumed : 0.0, pollMs * 1000.0 / steps);
+        if (polled != fired) std::printf("  (polling fired %llu times, the wheel %llu)\n",
+                                         static_cast<unsigned long long>(polled), static_cast<unsigned long long>(fired));
+    };
+    runRow("every step", [](std::mt19937 &) { return uint64_t{1}; });
+    runRow("240 (1 s)", [](std::mt19937 &) { return uint64_t{240}; });
+    runRow("uniform 1..4800", [](std::mt19937 &rng) { return std::uniform_int_distribution<uint64_t>(1, 4800)(rng); });
+    runRow("24000 (100 s)", [](std::mt19937 &) { return uint64_t{24000}; });
+}
+
+// Collision layers and the static partition: one combined unfiltered grid, whose candidates all reach
+// the narrow phase (as before layers existed), against the step's path (dynamic grid with filters,
+// plus dynamic bodies probed into a static grid that is not rebuilt). Statics are packed rows of
+// touching bodies (floors / walls); half the dynamics are debris that ignores other debris. Both
+// paths must find the same touching pairs.
+void benchLayers(){
+    const int n = 100000, reps = 10;
+    const float side = std::sqrt(1200.0f * n);
+    std::printf("== layers: n=%d, 50%% of dynamic bodies are debris (mask excludes debris), %d reps\n", n, reps);
+    std::printf("  %-8s %11s %11s %11s %11s %11s %11s %11s\n", "static", "combined ms", "split ms", "static bld",
+                "candidates", "static-stat", "pruned", "touching");
+    for (float staticShare : {0.0f, 0.25f, 0.5f}) {
+        std::mt19937 rng(17);
+        std::uniform_real_distribution<float> pos(0.0f, side), unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> radius(static_cast<float>(MIN_RADIUS), 10.0f);
+        const int statics = static_cast<int>(n * staticShare);
+        std::vector<quadItem> items(n);
+        std::vector<collisionFilter> filters(n);
+        std::vector<char> isStatic(n, 0);
+        const float staticRadius = 8.0f;
+        const int perRow = static_cast<int>(side / (2.0f * staticRadius));
+        for (int i = 0; i < n; ++i) {
+            if (i < statics) {
+                // Rows of touching bodies spread over the world.
+                int row = i / perRow, column = i % perRow;
+                float y = std::fmod(row * 97.0f * staticRadius, side);
+                items[i] = quadItem{(column + 0.5f) * 2.0f * staticRadius, y, staticRadius, 1.0f, i};
+                isStatic[i] = 1;
+                continue;
+            }
+            items[i] = quadItem{pos(rng), pos(rng), radius(rng), 1.0f, i};
+            if (unit(rng) < 0.5f) filters[i] = collisionFilter{LAYER_DEBRIS, LAYER_ALL & ~LAYER_DEBRIS};
+        }
+        auto touching = [&](int a, int b) {
+            const quadItem &p = items[a], &q = items[b];
+            float dx = p.x - q.x, dy = p.y - q.y, reach = p.radius + q.radius;
+            return dx * dx + dy * dy <= reach * reach;
+        };
+        std::vector<quadItem> dynamicItems(items.begin() + statics, items.end());
+        std::vector<collisionFilter> dynamicFilters(filters.begin() + statics, filters.end());
+
+        hierarchicalGrid combined;
+        long long candidates = 0, staticPairs = 0, combinedTouching = 0;
+        auto start = benchClock::now();
+        for (int r = 0; r < reps; ++r) {
+            candidates = staticPairs = combinedTouching = 0;
+            combined.build(items.data(), n);
+            combined.forEachCandidatePair([&](int a, int b) {
+                ++candidates;
+                if (!touching(a, b)) return;
+                if (isStatic[a] && isStatic[b]) ++staticPairs;
+                else if (filtersCollide(filters[a], filters[b])) ++combinedTouching;
+            });
+        }
+        double combinedMs = elapsedMs(start) / reps;
+
+        hierarchicalGrid staticGrid, dynamicGrid;
+        start = benchClock::now();
+        staticGrid.build(items.data(), statics, filters.data());
+        double staticBuildMs = elapsedMs(start);
+        long long pruned = 0, splitTouching = 0;
+        auto narrow = [&](int a, int b) { splitTouching += touching(a, b) ? 1 : 0; };
+        start = benchClock::now();
+        for (int r = 0; r < reps; ++r) {
+            splitTouching = 0;
+            dynamicGrid.build(dynamicItems.data(), static_cast<int>(dynamicItems.size()), dynamicFilters.data());
+            pruned = dynamicGrid.forEachCandidatePair(narrow);
+            pruned += dynamicGrid.forEachPairWith(staticGrid, narrow);
+        }
+        double splitMs = elapsedMs(start) / reps;
+        std::printf("  %7.0f%% %11.2f %11.2f %11.2f %11lld %11lld %11lld %11lld%s\n", staticShare * 100.0f, combinedMs,
+                    splitMs, staticBuildMs, candidates, staticPairs, pruned, splitTouching,
+                    splitTouching == combinedTouching ? "" : "  MISMATCH");
+    }
+}
+
+struct benchmarkEntry {
+    const char *name;
+    void (*run)();
+};
+
+const benchmarkEntry benchmarkTable[] = {
+    {"nbody", benchNbody},
+    {"queries", benchQueries},
+    {"broadphase", benchBroadphase},
+    {"diagnostics", benchDiagnostics},
+    {"export", benchExport},
+    {"commands", benchCommands},
+    {"history", benchHistory},
+    {"behaviours", benchBehaviours},
+    {"layers", benchLayers},
+};
+
+} // namespace
+
+int runBenchmarks(const char *name, void (*step)(double dt)){
+    simulationStep = step;
+    bool found = false;
+    for (const benchmarkEntry &entry : benchmarkTable) {
+        if (name && std::strcmp(name, entry.name) != 0) continue;
+        entry.run();
+        found = true;
+    }
+    if (!found) {
+        std::printf("unknown benchmark '%s'; available:", name);
+        for (const benchmarkEntry &entry : benchmarkTable) std::printf(" %s", entry.name);
+        std::printf("\n");
+        return 1;
+    }
+    return 0;
+}
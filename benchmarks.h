@@ -0,0 +1,11 @@
+// benchmarks: headless micro-benchmarks run with `main.exe --bench [name]` (no window is opened).
+#ifndef benchmarks_h
+#define benchmarks_h
+
+/**
+ * @brief Run the named benchmark (or all of them when `name` is null) and print results to stdout.
+ * `step` is the demo's full simulation step, for benchmarks that measure the real pipeline.
+ * @return process exit code (non-zero for an unknown name)
+ */
+int runBenchmarks(const char *name, void (*step)(double dt));
+#endif // benchmarks_h
@@ -0,0 +1,281 @@
+// commandQueue implementation: bounded MPSC ring, command constructors, and the POSIX socket feeder.
+
+#include "commandQueue.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+entityCommand entityCommand::spawn(double x, double y, double radius, double weight, Color color, int count){
+    entityCommand command;
+    command.type = commandType::Spawn;
+    command.x = x;
+    command.y = y;
+    command.radius = radius;
+    command.weight = weight;
+    command.color = color;
+    command.count = count;
+    return command;
+}
+
+entityCommand entityCommand::remove(entityHandle target){
+    entityCommand command;
+    command.type = commandType::Delete;
+    command.target = target;
+    return command;
+}
+
+entityCommand entityCommand::setVelocity(entityHandle target, double vx, double vy){
+    entityCommand command;
+    command.type = commandType::SetVelocity;
+    command.target = target;
+    command.x = vx;
+    command.y = vy;
+    return command;
+}
+
+entityCommand entityCommand::impulse(entityHandle target, double jx, double jy){
+    entityCommand command;
+    command.type = commandType::Impulse;
+    command.target = target;
+    command.x = jx;
+    command.y = jy;
+    return command;
+}
+
+entityCommand entityCommand::resize(entityHandle target, double radius){
+    entityCommand command;
+    command.type = commandType::Resize;
+    command.target = target;
+    command.radius = radius;
+    return command;
+}
+
+entityCommand entityCommand::setStatic(entityHandle target, bool pinned){
+    entityCommand command;
+    command.type = commandType::SetStatic;
+    command.target = target;
+    command.count = pinned ? 1 : 0;
+    return command;
+}
+
+entityCommand entityCommand::setLayers(entityHandle target, uint32_t layer, uint32_t mask){
+    entityCommand command;
+    command.type = commandType::SetLayers;
+    command.target = target;
+    command.layer = layer;
+    command.mask = mask;
+    return command;
+}
+
+entityCommand entityCommand::setBouncy(entityHandle target, bool bouncy){
+    entityCommand command;
+    command.type = commandType::SetBouncy;
+    command.target = target;
+    command.count = bouncy ? 1 : 0;
+    return command;
+}
+
+entityCommand entityCommand::jump(entityHandle target, double jx, double jy){
+    entityCommand command = impulse(target, jx, jy);
+    command.type = commandType::Jump;
+    return command;
+}
+
+commandQueue::commandQueue(size_t capacity){
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    cells.reset(new queueCell[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; ++i) cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool commandQueue::push(const entityCommand &command){
+    size_t position = enqueuePos.load(std::memory_order_relaxed);
+    queueCell *cell;
+    for (;;) {
+        cell = &cells[position & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (lag == 0) {
+            // Cell is free for this lap: claim it (on failure `position` is reloaded by the CAS).
+            if (enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if (lag < 0) {
+            // The consumer has not freed this cell yet: the ring is full.
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = enqueuePos.load(std::memory_order_relaxed); // another producer took it
+        }
+    }
+    cell->command = command;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+size_t commandQueue::depth() const {
+    size_t head = dequeuePos.load(std::memory_order_relaxed);
+    size_t tail = enqueuePos.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+uint64_t commandQueue::droppedCount() const {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+bool parseCommand(const char *line, entityCommand &out){
+    char verb[16];
+    int consumed = 0;
+    if (std::sscanf(line, "%15s%n", verb, &consumed) != 1) return false;
+    const char *args = line + consumed;
+    int slot = -1, count = 1;
+    double a = 0.0, b = 0.0, c = 0.0, d = 0.0;
+    if (std::strcmp(verb, "spawn") == 0) {
+        int fields = std::sscanf(args, "%lf %lf %lf %lf %d", &a, &b, &c, &d, &count);
+        if (fields < 4 || count < 1) return false;
+        out = entityCommand::spawn(a, b, c, d, RED, count);
+        return true;
+    }
+    if (std::strcmp(verb, "delete") == 0) {
+        if (std::sscanf(args, "%d", &slot) != 1) return false;
+        out = entityCommand::remove(entityHandle{slot, COMMAND_ANY_GENERATION});
+        return true;
+    }
+    if (std::strcmp(verb, "setvel") == 0 || std::strcmp(verb, "impulse") == 0) {
+        if (std::sscanf(args, "%d %lf %lf", &slot, &a, &b) != 3) return false;
+        entityHandle target{slot, COMMAND_ANY_GENERATION};
+        out = verb[0] == 's' ? entityCommand::setVelocity(target, a, b) : entityCommand::impulse(target, a, b);
+        return true;
+    }
+    if (std::strcmp(verb, "resize") == 0) {
+        if (std::sscanf(args, "%d %lf", &slot, &a) != 2) return false;
+        out = entityCommand::resize(entityHandle{slot, COMMAND_ANY_GENERATION}, a);
+        return true;
+    }
+    if (std::strcmp(verb, "static") == 0 || std::strcmp(verb, "bouncy") == 0) {
+        int flag = 0;
+        if (std::sscanf(args, "%d %d", &slot, &flag) != 2) return false;
+        entityHandle target{slot, COMMAND_ANY_GENERATION};
+        out = verb[0] == 's' ? entityCommand::setStatic(target, flag != 0) : entityCommand::setBouncy(target, flag != 0);
+        return true;
+    }
+    if (std::strcmp(verb, "layers") == 0) {
+        char layer[24], mask[24];
+        if (std::sscanf(args, "%d %23s %23s", &slot, layer, mask) != 3) return false;
+        // Base 0: decimal, or hex with a 0x prefix.
+        out = entityCommand::setLayers(entityHandle{slot, COMMAND_ANY_GENERATION},
+                                       static_cast<uint32_t>(std::strtoul(layer, nullptr, 0)),
+                                       static_cast<uint32_t>(std::strtoul(mask, nullptr, 0)));
+        return true;
+    }
+    return false;
+}
+
+#ifndef _WIN32
+commandFeeder::commandFeeder(commandQueue &queue) : queue(queue) {}
+
+commandFeeder::~commandFeeder(){
+    stop();
+}
+
+bool commandFeeder::start(const char *path){
+    stop();
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(address.sun_path)) return false;
+    std::strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    unlink(path); // stale socket file from an earlier run
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return false;
+    }
+    listenFd = fd;
+    socketPath = path;
+    running.store(true);
+    worker = std::thread(&commandFeeder::run, this);
+    return true;
+}
+
+void commandFeeder::stop(){
+    running.store(false);
+    if (worker.joinable()) worker.join();
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(socketPath.c_str());
+        listenFd = -1;
+    }
+}
+
+uint64_t commandFeeder::rejectedCount() const {
+    return rejected.load(std::memory_order_relaxed);
+}
+
+uint64_t commandFeeder::oversizedCount() const {
+    return oversized.load(std::memory_order_relaxed);
+}
+
+void commandFeeder::run(){
+    struct client {
+        int fd;
+        std::string pending; // bytes after the last complete line
+    };
+    std::vector<client> clients;
+    std::vector<pollfd> fds;
+    char buffer[4096];
+    while (running.load(std::memory_order_relaxed)) {
+        fds.assign(1, pollfd{listenFd, POLLIN, 0});
+        for (const client &c : clients) fds.push_back(pollfd{c.fd, POLLIN, 0});
+        // Short timeout so stop() is noticed promptly.
+        if (poll(fds.data(), fds.size(), 100) <= 0) continue;
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) clients.push_back(client{fd, std::string()});
+        }
+        for (size_t i = 1; i < fds.size(); ++i) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            client &c = clients[i - 1];
+            ssize_t got = read(c.fd, buffer, sizeof(buffer));
+            if (got <= 0) {
+                close(c.fd);
+                c.fd = -1;
+                continue;
+            }
+            c.pending.append(buffer, static_cast<size_t>(got));
+            size_t start = 0, newline;
+            while ((newline = c.pending.find('\n', start)) != std::string::npos) {
+                c.pending[newline] = '\0';
+                entityCommand command;
+                if (parseCommand(c.pending.c_str() + start, command)) {
+                    queue.push(command); // a full queue counts the drop itself
+                } else if (newline > start) {
+                    rejected.fetch_add(1, std::memory_order_relaxed);
+                }
+                start = newline + 1;
+            }
+            c.pending.erase(0, start);
+            if (c.pending.size() > COMMAND_LINE_MAX) {
+                // No newline in sight: the stream cannot be resynchronised, so drop the client.
+                oversized.fetch_add(1, std::memory_order_relaxed);
+                TraceLog(LOG_WARNING, "FEEDER: client dropped, %zu bytes without a newline (limit %d)",
+                         c.pending.size(), COMMAND_LINE_MAX);
+                close(c.fd);
+                c.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const client &c) { return c.fd < 0; }),
+                      clients.end());
+    }
+    for (const client &c : clients) close(c.fd);
+}
+#endif
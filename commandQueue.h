@@ -0,0 +1,162 @@
+// commandQueue: bounded lock-free multi-producer / single-consumer queue of entity mutations.
+/**
+ * @brief Every structural or state mutation of the entity pool goes through here.
+ * - Producers (input handling, other threads, the optional socket feeder) push() entityCommands;
+ *   push never blocks and fails when the queue is full (counted in droppedCount()).
+ * - The simulation drains the queue at one point in each step (drainEntityCommands in commands.cpp),
+ *   so nothing iterating entities can see the pool change under it.
+ * - Ring of COMMAND_QUEUE_CAPACITY cells with a per-cell sequence number (Vyukov's bounded queue):
+ *   producers claim a cell with one CAS on the enqueue counter; the consumer needs no atomics RMW.
+ */
+#ifndef commandQueue_h
+#define commandQueue_h
+#include "Entity.h"
+#include "raylib.h"
+#include "config.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+/** Generation that matches whatever entity occupies the slot when the command is applied. */
+constexpr unsigned int COMMAND_ANY_GENERATION = 0xFFFFFFFFu;
+
+enum class commandType : uint8_t {
+    Spawn,       ///< `count` entities at (x, y) with radius, weight, color
+    Delete,      ///< release the target
+    SetVelocity, ///< target velocity = (x, y)
+    Impulse,     ///< target velocity += (x, y) / mass (static bodies ignore it)
+    Resize,      ///< target radius = radius
+    SetStatic,   ///< pin (count != 0) or release (count == 0) the target; pinning also stops it
+    SetLayers,   ///< target collision layer / mask = layer / mask
+    SetBouncy,   ///< target bouncy flag = (count != 0)
+    Jump,        ///< like Impulse, and the target leaves the ground first
+};
+
+struct entityCommand {
+    commandType type{commandType::Spawn};
+    entityHandle target;   ///< Delete / SetVelocity / Impulse / Resize; stale handles are skipped
+    double x{0.0};         ///< Spawn position, or the velocity / impulse vector
+    double y{0.0};
+    double radius{0.0};    ///< Spawn, Resize
+    double weight{1.0};    ///< Spawn
+    Color color{RED};      ///< Spawn
+    int count{1};          ///< Spawn; SetStatic / SetBouncy flag
+    uint32_t layer{LAYER_DEFAULT}; ///< Spawn, SetLayers
+    uint32_t mask{LAYER_ALL};
+
+    static entityCommand spawn(double x, double y, double radius, double weight, Color color, int count = 1);
+    static entityCommand remove(entityHandle target);
+    static entityCommand setVelocity(entityHandle target, double vx, double vy);
+    static entityCommand impulse(entityHandle target, double jx, double jy);
+    static entityCommand resize(entityHandle target, double radius);
+    static entityCommand setStatic(entityHandle target, bool pinned);
+    static entityCommand setLayers(entityHandle target, uint32_t layer, uint32_t mask);
+    static entityCommand setBouncy(entityHandle target, bool bouncy);
+    static entityCommand jump(entityHandle target, double jx, double jy);
+};
+
+/** Counters of the last drain (simulation thread; copied into the render snapshot). */
+struct commandQueueStats {
+    int depth{0};          ///< commands waiting when the last drain started
+    int maxDepth{0};       ///< largest depth seen since start
+    int applied{0};        ///< commands applied by the last drain
+    double drainMs{0.0};   ///< wall time of the last drain
+    uint64_t total{0};     ///< commands applied since start
+    uint64_t dropped{0};   ///< pushes rejected because the queue was full
+};
+
+class commandQueue {
+    private:
+    struct alignas(64) queueCell {
+        std::atomic<size_t> sequence;
+        entityCommand command;
+    };
+    std::unique_ptr<queueCell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0}; // written by the consumer only; atomic so depth() can read it
+    std::atomic<uint64_t> dropped{0};
+    public:
+    /** `capacity` is rounded up to a power of two. */
+    explicit commandQueue(size_t capacity);
+
+    /** Any thread. Returns false (and counts a drop) when the queue is full. */
+    bool push(const entityCommand &command);
+
+    /**
+     * Consumer only: pop the commands that were queued when the call started and pass each to
+     * `apply`. Commands pushed meanwhile wait for the next drain. Returns the number applied.
+     */
+    template <class Fn>
+    int drain(Fn &&apply);
+
+    /** Approximate number of queued commands. */
+    size_t depth() const;
+    uint64_t droppedCount() const;
+};
+
+template <class Fn>
+int commandQueue::drain(Fn &&apply){
+    size_t position = dequeuePos.load(std::memory_order_relaxed);
+    const size_t end = enqueuePos.load(std::memory_order_acquire);
+    int applied = 0;
+    while (position != end) {
+        queueCell &cell = cells[position & mask];
+        // A producer that claimed this cell may still be writing it; stop and pick it up next drain.
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) break;
+        entityCommand command = cell.command;
+        cell.sequence.store(position + mask + 1, std::memory_order_release);
+        ++position;
+        dequeuePos.store(position, std::memory_order_relaxed);
+        apply(command);
+        ++applied;
+    }
+    return applied;
+}
+
+#ifndef _WIN32
+/**
+ * @brief Optional local feeder (POSIX): a Unix domain socket accepting one text command per line,
+ * pushed straight into a commandQueue. Entities are addressed by slot (any generation):
+ *     spawn <x> <y> <radius> <weight> [count]
+ *     delete <slot>
+ *     setvel <slot> <vx> <vy>
+ *     impulse <slot> <jx> <jy>
+ *     resize <slot> <radius>
+ *     static <slot> <0|1>
+ *     layers <slot> <layer> <mask>     (bit sets, decimal or 0x hex)
+ *     bouncy <slot> <0|1>
+ * Malformed lines are ignored. Several clients may be connected at once. A client whose line runs past
+ * COMMAND_LINE_MAX bytes without a newline is disconnected (counted in oversizedCount()), so a peer
+ * cannot make the feeder buffer without bound.
+ */
+class commandFeeder {
+    private:
+    commandQueue &queue;
+    std::string socketPath;
+    int listenFd{-1};
+    std::atomic<bool> running{false};
+    std::thread worker;
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> oversized{0};
+    void run();
+    public:
+    explicit commandFeeder(commandQueue &queue);
+    ~commandFeeder();
+
+    /** Bind `path` (an old socket file there is replaced) and start the feeder thread. */
+    bool start(const char *path);
+    void stop();
+    /** Lines that failed to parse. */
+    uint64_t rejectedCount() const;
+    /** Clients disconnected for a line longer than COMMAND_LINE_MAX. */
+    uint64_t oversizedCount() const;
+};
+#endif
+
+/** Parse one feeder line (see commandFeeder); false if malformed. */
+bool parseCommand(const char *line, entityCommand &out);
+#endif // commandQueue_h
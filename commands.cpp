@@ -1,6 +1,12 @@
 #include "commands.h"
 #include "rlgl.h"
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <new>
 
 // Define globals (single definition)
 std::vector<Entity*> players(MAX_ENTITIES, nullptr);
@@ -9,51 +15,318 @@ double y = 0.0;
 physicsEffects physics;
 inputManager inputMgr;
 windowInteractions windowInt;
+std::atomic<int> worldWidth{0};
+std::atomic<int> worldHeight{0};
+quadTree worldTree;
+hierarchicalGrid collisionGrid;
+hierarchicalGrid staticGrid;
+contactStream contacts;
+std::atomic<bool> diagnosticsEnabled{false};
+stepDiagnostics lastDiagnostics;
+stateWriter stateExport;
+commandQueue entityCommands(COMMAND_QUEUE_CAPACITY);
+commandQueueStats commandStats;
+behaviourScheduler behaviours;
+rewindHistory stepHistory(historyPool{&players, entitySlotEnd, restoreEntitySlots, releaseEntity},
+                          static_cast<size_t>(HISTORY_MEMORY_MB) << 20, HISTORY_KEYFRAME_INTERVAL, MAX_ENTITIES);
+std::atomic<bool> rewindActive{false};
+std::atomic<int> rewindOffset{0};
+std::atomic<bool> historyEnabled{HISTORY_ENABLED};
+std::atomic<bool> budgetEnabled{true};
+int solverIterations{SOLVER_ITERATIONS};
+int historyInterval{1};
+std::atomic<bool> nbodyEnabled{false};
+std::atomic<float> nbodyTheta{static_cast<float>(NBODY_THETA)};
 
-void initializePlayers(){
+// Slot pool: entities live in fixed-size pages so an entity's address never changes while its
+// slot is live. players[i] points into the page when slot i is in use and is nullptr when free.
+// Pages are left uninitialized and each cell is constructed the first time its slot is handed out,
+// so a bulk spawn touches every entity's memory once.
+static constexpr int ENTITY_PAGE_SIZE = 4096;
+struct entityCell {
+  alignas(Entity) unsigned char bytes[sizeof(Entity)];
+};
+static std::vector<std::unique_ptr<entityCell[]>> entityPages;
+static std::vector<int> freeSlots; // released slots, reused LIFO
+static int slotHighWater = 0;      // slots [0, slotHighWater) have been constructed at least once
+static std::vector<unsigned int> slotGeneration; // bumped on release so stale entityHandles stop resolving
+
+// splitmix64: cheap per-field sampling for bulk spawns (GetRandomValue per field is far slower).
+static uint64_t spawnRngState = 0x9E3779B97F4A7C15ull;
+
+static uint64_t nextRandom(){
+  uint64_t z = (spawnRngState += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+static double sample(const spawnRange &range){
+  if (range.max <= range.min) return range.min;
+  double t = static_cast<double>(nextRandom() >> 11) * (1.0 / 9007199254740992.0); // [0,1)
+  return range.min + (range.max - range.min) * t;
+}
+
+static Color sampleColor(Color a, Color b){
+  if (a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a) return a;
+  int t = static_cast<int>(nextRandom() >> 56); // 0..255
+  auto lerp = [t](unsigned char from, unsigned char to) {
+    return static_cast<unsigned char>(from + ((to - from) * t) / 255);
+  };
+  return Color{lerp(a.r, b.r), lerp(a.g, b.g), lerp(a.b, b.b), lerp(a.a, b.a)};
+}
+
+static void *slotStorage(int slot){
+  // Allocate backing pages on demand up to and including the one holding `slot`.
+  int page = slot / ENTITY_PAGE_SIZE;
+  while (static_cast<int>(entityPages.size()) <= page) {
+    entityPages.emplace_back(new entityCell[ENTITY_PAGE_SIZE]);
+  }
+  return entityPages[page][slot % ENTITY_PAGE_SIZE].bytes;
+}
+
+static Entity *occupySlot(int slot, bool fresh, double x, double y, double radius, double weight, Color color){
+  // Fresh slots (from the high-water mark) are raw memory; recycled slots hold a live Entity to overwrite.
+  Entity *entity;
+  if (fresh) {
+    entity = new (slotStorage(slot)) Entity("", x, y, 0, radius, weight, color);
+  } else {
+    entity = static_cast<Entity*>(slotStorage(slot));
+    *entity = Entity("", x, y, 0, radius, weight, color);
+  }
+  entity->set_id(slot);
+  players[slot] = entity;
+  return entity;
+}
+
+void initializePlayers(int count){
   // Create a pool of entities with randomized starting positions and small initial horizontal velocity.
-  // Use current screen center at initialization time to avoid calling raylib before InitWindow.
+  // Uses the published world size, so call it after InitWindow has set worldWidth/worldHeight.
   SetRandomSeed(time(NULL));
-  double centerX = static_cast<double>(GetScreenWidth()) / 2.0;
-  double centerY = static_cast<double>(GetScreenHeight()) / 2.0;
-  for (int i{0}; i < INITIAL_ENTITIES; i++){
-    Entity* player = new Entity("player "+ std::to_string(i+1),
-                                  GetRandomValue(0,centerX*2),
-                                  GetRandomValue(0,centerY*2),
-                                  0, GetRandomValue(1,5), GetRandomValue(1,100), RED);
-    if (player == nullptr) continue;
-    players[i] = player;
-    players[i]->set_vx(GetRandomValue(-20,20));
-    players[i]->set_vy(GetRandomValue(-20,20));
-    physics.addToEntityList(players[i]);
-    inputMgr.addToEntityList(players[i]);
-    windowInt.addToEntityList(players[i]);
-  }
+  spawnRngState ^= static_cast<uint64_t>(time(NULL));
+  spawnParams params;
+  params.x = {0.0, static_cast<double>(worldWidth.load())};
+  params.y = {0.0, static_cast<double>(worldHeight.load())};
+  params.vx = {-20.0, 20.0};
+  params.vy = {-20.0, 20.0};
+  params.radius = {1.0, 5.0};
+  params.weight = {1.0, 100.0};
+  params.colorA = params.colorB = RED;
+  SpawnEntities(count, params);
 }
 
 void SpawnEntity(double x, double y, double radius, double weight, Color color, int nEnts){
-  // Spawn up to nEnts into available pre-sized slots without resize/push_back
-  int spawned = 0;
-  for (int i = 0; i < MAX_ENTITIES && spawned < nEnts; ++i) {
-    if (players[i] != nullptr) continue;
-    Entity* newEntity = new Entity("player " + std::to_string(i+1), x, y, 0, radius, weight, color);
-    if (!newEntity) break;
-    players[i] = newEntity;
-    physics.addToEntityList(players[i]);
-    inputMgr.addToEntityList(players[i]);
-    windowInt.addToEntityList(players[i]);
-    ++spawned;
+  // Constant parameters through the block path (same slot policy and registration as SpawnEntities).
+  spawnParams params;
+  params.x = {x, x};
+  params.y = {y, y};
+  params.radius = {radius, radius};
+  params.weight = {weight, weight};
+  params.colorA = params.colorB = color;
+  SpawnEntities(nEnts, params);
+}
+
+int SpawnEntities(int count, const spawnParams &params){
+  if (count <= 0) return 0;
+  // Released slots first, so spawn/despawn churn does not grow the pool; the rest is one contiguous
+  // block at the tail.
+  int fromFree = std::min(count, static_cast<int>(freeSlots.size()));
+  int blockStart = slotHighWater;
+  int blockCount = std::min(count - fromFree, MAX_ENTITIES - slotHighWater);
+  slotHighWater += blockCount;
+  slotGeneration.resize(slotHighWater);
+
+  std::vector<Entity*> spawned;
+  spawned.reserve(blockCount + fromFree);
+  auto fill = [&](int slot, bool fresh) {
+    Entity *entity = occupySlot(slot, fresh, sample(params.x), sample(params.y), sample(params.radius),
+                                sample(params.weight), sampleColor(params.colorA, params.colorB));
+    entity->setVelocity(sample(params.vx), sample(params.vy));
+    entity->setCollisionLayer(params.filter.layer);
+    entity->setCollisionMask(params.filter.mask);
+    stepHistory.markChanged(slot);
+    spawned.push_back(entity);
+  };
+  for (int i = 0; i < fromFree; ++i) {
+    fill(freeSlots.back(), false);
+    freeSlots.pop_back();
   }
+  for (int slot = blockStart; slot < blockStart + blockCount; ++slot) fill(slot, true);
+
+  // Managers are indexed by slot, so registration is one write per entity and manager.
+  physics.addRangeToEntityList(spawned.data(), spawned.size());
+  inputMgr.addRangeToEntityList(spawned.data(), spawned.size());
+  windowInt.addRangeToEntityList(spawned.data(), spawned.size());
+  return static_cast<int>(spawned.size());
+}
+
+void releaseEntity(int slot){
+  Entity *entity = players[slot];
+  if (!entity) return;
+  physics.removeFromEntityList(entity);
+  inputMgr.removeFromEntityList(entity);
+  windowInt.removeFromEntityList(entity);
+  players[slot] = nullptr; // storage stays in its page for reuse
+  stepHistory.markChanged(slot);
+  ++slotGeneration[slot];
+  freeSlots.push_back(slot);
+}
+
+void restoreEntitySlots(const std::vector<int> &slots){
+  // Slots below the high-water mark were constructed before, so occupySlot overwrites in place.
+  std::vector<uint8_t> wanted(slotHighWater, 0);
+  for (int slot : slots) wanted[slot] = 1;
+  freeSlots.erase(std::remove_if(freeSlots.begin(), freeSlots.end(), [&](int slot) { return wanted[slot] != 0; }),
+                  freeSlots.end());
+  std::vector<Entity*> restored;
+  restored.reserve(slots.size());
+  for (int slot : slots) restored.push_back(occupySlot(slot, false, 0.0, 0.0, MIN_RADIUS, 1.0, RED));
+  physics.addRangeToEntityList(restored.data(), restored.size());
+  inputMgr.addRangeToEntityList(restored.data(), restored.size());
+  windowInt.addRangeToEntityList(restored.data(), restored.size());
+}
+
+static Entity *commandTarget(entityHandle target){
+  // Feeder commands address a slot, not a particular occupant.
+  if (target.generation == COMMAND_ANY_GENERATION) {
+    return target.slot >= 0 && target.slot < slotHighWater ? players[target.slot] : nullptr;
+  }
+  return resolveHandle(target);
+}
+
+static void applyCommand(const entityCommand &command){
+  if (command.type == commandType::Spawn) {
+    spawnParams params;
+    params.x = {command.x, command.x};
+    params.y = {command.y, command.y};
+    params.radius = {command.radius, command.radius};
+    params.weight = {command.weight, command.weight};
+    params.colorA = params.colorB = command.color;
+    params.filter = collisionFilter{command.layer, command.mask};
+    SpawnEntities(command.count, params);
+    return;
+  }
+  Entity *entity = commandTarget(command.target);
+  if (!entity) return; // released since the command was queued
+  stepHistory.markChanged(entity->get_id());
+  switch (command.type) {
+    case commandType::Delete:
+      releaseEntity(entity->get_id());
+      break;
+    case commandType::SetVelocity:
+      entity->setVelocity(command.x, command.y);
+      break;
+    case commandType::Jump:
+      entity->setOnGround(false); // otherwise integration keeps it clamped to the floor
+      [[fallthrough]];
+    case commandType::Impulse:
+      if (!entity->getEntityStatic()) {
+        double mass = std::max(1.0, entity->getWeight());
+        entity->addToVx(command.x / mass);
+        entity->addToVy(command.y / mass);
+      }
+      break;
+    case commandType::Resize:
+      entity->set_radius(command.radius); // bounds pass clamps to [MIN_RADIUS, MAX_RADIUS]
+      break;
+    case commandType::SetStatic:
+      entity->setStatic(command.count != 0);
+      if (command.count != 0) entity->setVelocity(0.0, 0.0);
+      break;
+    case commandType::SetLayers:
+      entity->setCollisionLayer(command.layer);
+      entity->setCollisionMask(command.mask);
+      break;
+    case commandType::SetBouncy:
+      entity->setEntityBouncy(command.count != 0);
+      break;
+    case commandType::Spawn:
+      break;
+  }
+}
+
+int drainEntityCommands(){
+  auto start = std::chrono::steady_clock::now();
+  commandStats.depth = static_cast<int>(entityCommands.depth());
+  commandStats.maxDepth = std::max(commandStats.maxDepth, commandStats.depth);
+  commandStats.applied = entityCommands.drain(applyCommand);
+  commandStats.total += static_cast<uint64_t>(commandStats.applied);
+  commandStats.dropped = entityCommands.droppedCount();
+  commandStats.drainMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return commandStats.applied;
+}
+
+entityHandle handleOf(int slot){
+  return entityHandle{slot, slotGeneration[slot]};
+}
+
+Entity *resolveHandle(entityHandle handle){
+  if (handle.slot < 0 || handle.slot >= slotHighWater) return nullptr;
+  if (slotGeneration[handle.slot] != handle.generation) return nullptr;
+  return players[handle.slot];
+}
+
+void gatherEntitySamples(std::vector<quadItem> &out){
+  out.clear();
+  for (int i = 0; i < slotHighWater; ++i) {
+    const Entity *entity = players[i];
+    if (!entity) continue;
+    // Same mass convention as resolveCollision: weight, floored at 1.
+    float mass = static_cast<float>(std::max(1.0, entity->getWeight()));
+    out.push_back(quadItem{static_cast<float>(entity->get_x()), static_cast<float>(entity->get_y()),
+                           static_cast<float>(entity->get_radius()), mass, i});
+  }
+}
+
+void splitCollisionSamples(const std::vector<quadItem> &samples, collisionSamples &out){
+  out.dynamicItems.clear();
+  out.dynamicFilters.clear();
+  out.staticItems.clear();
+  out.staticFilters.clear();
+  uint64_t fingerprint = 0xcbf29ce484222325ull; // FNV-1a over the static bodies, in slot order
+  auto mix = [&fingerprint](uint64_t value) {
+    fingerprint ^= value;
+    fingerprint *= 0x100000001b3ull;
+  };
+  auto bits = [](float value) {
+    uint32_t out;
+    std::memcpy(&out, &value, sizeof(out));
+    return static_cast<uint64_t>(out);
+  };
+  for (const quadItem &item : samples) {
+    const Entity *entity = players[item.slot];
+    collisionFilter filter{entity->getCollisionLayer(), entity->getCollisionMask()};
+    if (!entity->getEntityStatic()) {
+      out.dynamicItems.push_back(item);
+      out.dynamicFilters.push_back(filter);
+      continue;
+    }
+    out.staticItems.push_back(item);
+    out.staticFilters.push_back(filter);
+    mix(static_cast<uint64_t>(item.slot));
+    mix(bits(item.x) | bits(item.y) << 32);
+    mix(bits(item.radius));
+    mix(static_cast<uint64_t>(filter.layer) | static_cast<uint64_t>(filter.mask) << 32);
+  }
+  out.staticFingerprint = fingerprint;
+}
+
+int entitySlotEnd(){
+  return slotHighWater;
 }
 
-void drawPlayers(){
+void drawPlayers(const renderSnapshot &snapshot, float lodRadius){
   // Ensure there's room in rlgl batch
-  rlCheckRenderBatchLimit(MAX_ENTITIES * 6);
+  rlCheckRenderBatchLimit(static_cast<int>(snapshot.count) * 6);
 
-    // Debug: draw using raylib's DrawCircle to verify entities are visible
-    for (int i = 0; i < MAX_ENTITIES; ++i) {
-      if (!players[i]) continue;
-      DrawCircle(static_cast<int>(players[i]->get_x()), static_cast<int>(players[i]->get_y()),
-                 static_cast<float>(players[i]->get_radius()), players[i]->get_color());
+    // Draw from the snapshot only; the simulation thread may be mutating `players` meanwhile.
+    for (size_t i = 0; i < snapshot.count; ++i) {
+      if (snapshot.radius[i] < lodRadius) {
+        // Level of detail: 6 triangles instead of a full circle fan.
+        DrawPoly(Vector2{snapshot.x[i], snapshot.y[i]}, 6, snapshot.radius[i], 0.0f, snapshot.color[i]);
+        continue;
+      }
+      DrawCircle(static_cast<int>(snapshot.x[i]), static_cast<int>(snapshot.y[i]),
+                 snapshot.radius[i], snapshot.color[i]);
     }
 }
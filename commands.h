@@ -1,9 +1,21 @@
+#ifndef commands_h
+#define commands_h
 #include "raylib.h"
 #include "Entity.h"
 #include "physicsEffects.h"
 #include "inputManager.h"
 #include "windowInteractions.h"
 #include "config.h"
+#include "simulation.h"
+#include "quadTree.h"
+#include "hierarchicalGrid.h"
+#include "contactEvents.h"
+#include "diagnostics.h"
+#include "stateExport.h"
+#include "commandQueue.h"
+#include "rewindHistory.h"
+#include "behaviours.h"
+#include <atomic>
 #include <ctime>
 
 // Globals are defined in commands.cpp to avoid multiple-definition linker errors.
@@ -13,9 +25,107 @@ extern double y;
 extern physicsEffects physics;
 extern inputManager inputMgr;
 extern windowInteractions windowInt;
+// Playfield size in pixels. Written by the main thread from the window each frame, read by the simulation thread.
+extern std::atomic<int> worldWidth;
+extern std::atomic<int> worldHeight;
+// Spatial tree rebuilt once per step; serves N-body gravity and the spatial queries (mouse picking).
+extern quadTree worldTree;
+// Collision broadphase over dynamic bodies, rebuilt once per step from the same samples as worldTree.
+extern hierarchicalGrid collisionGrid;
+// Broadphase over static bodies, rebuilt only when the static set changes (see splitCollisionSamples).
+extern hierarchicalGrid staticGrid;
+// Contact events of the last completed collision pass.
+extern contactStream contacts;
+// Diagnostics stage: enabled flag (toggled with F3 from the main thread) and the last measured step.
+extern std::atomic<bool> diagnosticsEnabled;
+extern stepDiagnostics lastDiagnostics; // simulation thread; the renderer reads the snapshot copy
+// Entity mutations from any thread; drained once per step by drainEntityCommands (simulation thread).
+extern commandQueue entityCommands;
+extern commandQueueStats commandStats; // simulation thread; the renderer reads the snapshot copy
+// Frame-budget controllers: enabled flag (toggled with F4 from the main thread), and the solver
+// iteration count and history record interval chosen by the step budget (simulation thread).
+extern std::atomic<bool> budgetEnabled;
+extern int solverIterations;
+extern int historyInterval;
+// Scripted behaviours, resumed once per step before the command drain (simulation thread).
+extern behaviourScheduler behaviours;
+// Recent steps for rewinding (simulation thread). The main thread drives it through rewindActive
+// (R) and rewindOffset, the number of frames back from the newest one (LEFT/RIGHT, HOME/END), and
+// turns recording on and off with historyEnabled (H; turning it off drops the recorded frames).
+extern rewindHistory stepHistory;
+extern std::atomic<bool> rewindActive;
+extern std::atomic<int> rewindOffset;
+extern std::atomic<bool> historyEnabled;
+// Shared-memory export of every step for external readers; open only when run with --export.
+extern stateWriter stateExport;
+// N-body settings, toggled from the main thread (N, [ and ]) and read by the simulation thread.
+extern std::atomic<bool> nbodyEnabled;
+extern std::atomic<float> nbodyTheta;
+
+/** Uniform [min, max] range sampled once per spawned entity; min == max gives a constant. */
+struct spawnRange {
+    double min{0.0};
+    double max{0.0};
+};
+
+/**
+ * @brief Parameter distributions for SpawnEntities.
+ * Each field is sampled independently; color is interpolated between colorA and colorB.
+ */
+struct spawnParams {
+    spawnRange x;
+    spawnRange y;
+    spawnRange vx;
+    spawnRange vy;
+    spawnRange radius{MIN_RADIUS, MIN_RADIUS};
+    spawnRange weight{1.0, 1.0};
+    Color colorA{RED};
+    Color colorB{RED};
+    collisionFilter filter; ///< same for every spawned entity
+};
+
+/** Per-step input of the collision broadphase, split by mobility (see splitCollisionSamples). */
+struct collisionSamples {
+    std::vector<quadItem> dynamicItems;
+    std::vector<collisionFilter> dynamicFilters;
+    std::vector<quadItem> staticItems;
+    std::vector<collisionFilter> staticFilters;
+    uint64_t staticFingerprint{0}; ///< hash of every static body's slot, position, radius and filter
+};
 
 // Function prototypes implemented in commands.cpp
-void initializePlayers();
+void initializePlayers(int count = INITIAL_ENTITIES);
 void SpawnEntity(double x, double y, double radius, double weight, Color color, int nEnts);
-void drawPlayers();
-
+/**
+ * @brief Spawn `count` entities sampled from `params`.
+ * Released slots are reused first; the remainder is reserved in a single step as one contiguous
+ * block at the pool's high-water mark. Registration with the managers is O(1) per entity (their
+ * lists are indexed by slot). Returns the number actually spawned.
+ */
+int SpawnEntities(int count, const spawnParams &params);
+/** Unregister the entity in `slot` from every manager and return the slot to the free list (O(1)). */
+void releaseEntity(int slot);
+/** Rewind: put released `slots` back in the pool; the caller then writes their state. */
+void restoreEntitySlots(const std::vector<int> &slots);
+/**
+ * Apply every command queued in entityCommands (simulation thread, once per step) and update
+ * commandStats. Returns the number applied.
+ */
+int drainEntityCommands();
+/** Handle for the entity currently in `slot`. */
+entityHandle handleOf(int slot);
+/** The entity a handle refers to, or nullptr if it was released (even if the slot was reused). */
+Entity *resolveHandle(entityHandle handle);
+/** Fill `out` with position/radius/mass samples of every live entity (mass = weight floored at 1). */
+void gatherEntitySamples(std::vector<quadItem> &out);
+/**
+ * Split `samples` (from gatherEntitySamples) into dynamic and static bodies with their collision
+ * filters. The static fingerprint changes whenever a body becomes or stops being static, or a static
+ * body moves, resizes, changes layers or is released, so the caller can skip rebuilding staticGrid.
+ */
+void splitCollisionSamples(const std::vector<quadItem> &samples, collisionSamples &out);
+/** One past the highest slot ever handed out; loops over `players` can stop here. */
+int entitySlotEnd();
+/** Draw the entities of a published snapshot (main thread); circles below `lodRadius` are drawn as hexagons. */
+void drawPlayers(const renderSnapshot &snapshot, float lodRadius = 0.0f);
+#endif // commands_h
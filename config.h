@@ -3,9 +3,27 @@
 #define config_H
 #include "raylib.h"
 
-#define MAX_ENTITIES 1000
+#define MAX_ENTITIES 1000000 // slot pool capacity; pages are allocated on demand
 #define INITIAL_ENTITIES 500
 #define SPEED_MULT 1.0
+#define SIM_STEP_HZ 240 // simulation thread step rate, independent of the render frame rate
+#define MAX_SUBSTEP_LEVEL 5 // fast bodies integrate in up to 2^5 = 32 substeps per step
+#define SUBSTEP_TRAVEL_FRACTION 0.5 // target max travel per substep, as a fraction of the body's radius
+#define TARGET_FPS 60
+#define SOLVER_ITERATIONS 1 // collision solver passes per step by default
+#define SOLVER_ITERATIONS_MAX 3 // passes the step budget may raise to when it has headroom
+#define SLEEP_STEPS (SIM_STEP_HZ / 4) // steps a supported body must stay below the sleep speed before it sleeps
+
+// Frame-budget controllers (see frameBudget.h): the simulation step trades max substep level, solver
+// iterations, sleep speed and the history record interval for time; the renderer trades its circle LOD radius.
+#define SIM_STEP_BUDGET_MS (0.8 * 1000.0 / SIM_STEP_HZ) // 80% of the step period
+#define RENDER_FRAME_BUDGET_MS (0.5 * 1000.0 / TARGET_FPS) // entity drawing; leaves the rest for overlay and swap
+#define BUDGET_SMOOTHING 0.1      // exponential smoothing factor for per-phase costs
+#define BUDGET_DEGRADE_FRAMES 10  // consecutive over-budget frames before one knob is cheapened
+#define BUDGET_RECOVER_FRAMES 120 // consecutive frames under BUDGET_RECOVER_SHARE before one notch is restored
+#define BUDGET_RECOVER_SHARE 0.6
+#define SLEEP_SPEED_MAX 8.0       // pixels/s; cheapest sleep setting
+#define DRAW_LOD_RADIUS_MAX 24.0  // pixels; circles below the LOD radius are drawn as hexagons
 
 #define GRAVITY 10 // pixels per second squared
 #define BOUNCE 0.9 // higher is bouncier lower is less bouncy
@@ -18,6 +36,50 @@
 #define MAX_FALL_SPEED 15000.0
 
 
+// N-body mode (toggle with N): entities attract each other by weight via a Barnes–Hut quadtree.
+#define NBODY_G 2000.0        // gravitational constant in pixels^3 / (weight * s^2)
+#define NBODY_THETA 0.5       // default opening angle; [ and ] adjust it at runtime
+#define NBODY_SOFTENING 100.0 // pixels^2 added to squared distances
+#define QUADTREE_LEAF_SIZE 8
+#define QUADTREE_MAX_DEPTH 20
+// Collision filtering: a pair collides only when each body's layer is in the other's mask.
+#define LAYER_DEFAULT 0x1u
+#define LAYER_PLAYER 0x2u
+#define LAYER_DEBRIS 0x4u        // emitter output: collides with the world but not with the player
+#define LAYER_ALL 0xFFFFFFFFu
+// Collision broadphase: hierarchical grid, one level per radius class (see hierarchicalGrid.h).
+#define HGRID_MAX_LEVELS 8
+#define HGRID_MIN_LEVEL_SHARE 0.02 // radius classes holding fewer than 2% of bodies are merged upward
+#define HGRID_OCCUPANCY_BITS_PER_CELL 64 // occupancy bitmap only when the level's bounds are this dense or denser
+
+// Entity command queue (see commandQueue.h).
+#define COMMAND_QUEUE_CAPACITY 65536 // power of two; pushes beyond it are dropped and counted
+#define COMMAND_SOCKET_PATH "/tmp/physics_demo.sock" // Unix socket opened by --listen (POSIX only)
+#define COMMAND_LINE_MAX 256 // bytes; a feeder client that sends a longer line is disconnected and counted
+
+// Scripted behaviours (see behaviours.h): E / T / P attach one to the selection, or to the player.
+#define EMITTER_INTERVAL_STEPS 60 // one body every 0.25 s
+#define EMITTER_COUNT 40
+#define DESPAWN_DELAY_STEPS 720   // 3 s
+#define PATROL_RANGE 400.0        // pixels
+#define PATROL_SPEED 200.0        // pixels/s
+#define PATROL_STEER_STEPS 12     // steps between velocity updates
+
+// Rewind history (see rewindHistory.h; R pauses and rewinds, LEFT/RIGHT scrub, H toggles recording).
+#define HISTORY_ENABLED true           // record steps from startup
+#define HISTORY_RECORD_INTERVAL_MAX 8  // steps per recorded frame the step budget may thin recording to
+#define HISTORY_MEMORY_MB 256          // recorded frames beyond this drop their oldest keyframe group
+#define HISTORY_KEYFRAME_INTERVAL 240  // frames between full keyframes (1 s at SIM_STEP_HZ when every step is recorded)
+#define HISTORY_POSITION_EPSILON 0.01  // pixels; smaller moves are not recorded as changes
+#define HISTORY_VELOCITY_EPSILON 0.01  // pixels/s
+#ifndef HISTORY_VERIFY_MARKS
+#define HISTORY_VERIFY_MARKS 0         // 1: check every delta against a full diff (slow; see rewindHistory.h)
+#endif
+
+// Shared-memory state export (run with --export; see stateExport.h).
+#define STATE_EXPORT_NAME "physics_demo_state"
+#define STATE_EXPORT_CAPACITY MAX_ENTITIES // entities per exported frame; larger pools are truncated
+
 #define MAX_RADIUS 100.0
 #define MIN_RADIUS 5.0
 
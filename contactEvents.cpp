@@ -0,0 +1,70 @@
+// contactEvents implementation: sort the step's contacts by pair key and merge with the previous step.
+
+#include "contactEvents.h"
+#include <algorithm>
+
+static uint64_t pairKey(int slotA, int slotB){
+    uint32_t lo = static_cast<uint32_t>(std::min(slotA, slotB));
+    uint32_t hi = static_cast<uint32_t>(std::max(slotA, slotB));
+    return (static_cast<uint64_t>(lo) << 32) | hi;
+}
+
+void contactStream::beginStep(){
+    current.clear();
+}
+
+void contactStream::report(entityHandle a, entityHandle b, float nx, float ny, float impulse){
+    current.push_back(contactRecord{pairKey(a.slot, b.slot), a, b, nx, ny, impulse});
+}
+
+void contactStream::endStep(){
+    auto byKey = [](const contactRecord &l, const contactRecord &r) { return l.key < r.key; };
+    std::sort(current.begin(), current.end(), byKey);
+
+    events.clear();
+    ended.clear();
+    auto toEvent = [](const contactRecord &record, contactPhase phase) {
+        return contactEvent{record.a, record.b, record.nx, record.ny, record.impulse, phase};
+    };
+    // A pair only persists if both slots still hold the same entities (generations match);
+    // otherwise a reused slot would make an unrelated body look like a continuing contact.
+    auto sameBodies = [](const contactRecord &l, const contactRecord &r) {
+        unsigned int lg = l.a.slot < l.b.slot ? l.a.generation : l.b.generation;
+        unsigned int lh = l.a.slot < l.b.slot ? l.b.generation : l.a.generation;
+        unsigned int rg = r.a.slot < r.b.slot ? r.a.generation : r.b.generation;
+        unsigned int rh = r.a.slot < r.b.slot ? r.b.generation : r.a.generation;
+        return lg == rg && lh == rh;
+    };
+
+    size_t p = 0;
+    for (const contactRecord &record : current) {
+        while (p < previous.size() && previous[p].key < record.key) {
+            ended.push_back(toEvent(previous[p], contactPhase::End));
+            ++p;
+        }
+        if (p < previous.size() && previous[p].key == record.key) {
+            if (sameBodies(previous[p], record)) {
+                events.push_back(toEvent(record, contactPhase::Persist));
+            } else {
+                ended.push_back(toEvent(previous[p], contactPhase::End));
+                events.push_back(toEvent(record, contactPhase::Begin));
+            }
+            ++p;
+        } else {
+            events.push_back(toEvent(record, contactPhase::Begin));
+        }
+    }
+    for (; p < previous.size(); ++p) {
+        ended.push_back(toEvent(previous[p], contactPhase::End));
+    }
+    events.insert(events.end(), ended.begin(), ended.end());
+    previous.swap(current);
+}
+
+const std::vector<contactEvent> &contactStream::getEvents() const {
+    return events;
+}
+
+size_t contactStream::activeContacts() const {
+    return previous.size();
+}
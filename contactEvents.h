@@ -0,0 +1,63 @@
+// contactEvents: per-step buffer of pair contact events produced by the collision pass.
+/**
+ * @brief Replaces the per-entity `isColliding` flag with a compact event stream.
+ * - The collision pass calls report() for every touching pair; endStep() diffs the step's contacts
+ *   against the previous step's and emits Begin / Persist / End events in one bulk pass.
+ * - Events carry entity handles (slot + generation), the contact normal (pointing from b to a)
+ *   and the impulse magnitude applied by the solver (0 when the bodies were already separating).
+ * - Nothing is stored on entities, so there is no per-entity state to reset each step.
+ */
+#ifndef contactEvents_h
+#define contactEvents_h
+#include "Entity.h"
+#include <cstdint>
+#include <vector>
+
+enum class contactPhase : uint8_t {
+    Begin,   ///< pair started touching this step
+    Persist, ///< pair was already touching last step
+    End,     ///< pair touched last step but not this one (normal/impulse are the last known values)
+};
+
+struct contactEvent {
+    entityHandle a;
+    entityHandle b;
+    float nx;
+    float ny;
+    float impulse;
+    contactPhase phase;
+};
+
+class contactStream {
+    private:
+    struct contactRecord {
+        uint64_t key; // (min slot << 32) | max slot
+        entityHandle a;
+        entityHandle b;
+        float nx;
+        float ny;
+        float impulse;
+    };
+    std::vector<contactRecord> current;  // reported this step (unsorted until endStep)
+    std::vector<contactRecord> previous; // last step's contacts, sorted by key
+    std::vector<contactEvent> events;
+    std::vector<contactEvent> ended; // scratch, appended to `events` after the merge
+    public:
+    contactStream() = default;
+
+    /** Start collecting a new step's contacts. */
+    void beginStep();
+
+    /** Record a touching pair. Each unordered pair should be reported at most once per step. */
+    void report(entityHandle a, entityHandle b, float nx, float ny, float impulse);
+
+    /** Diff against the previous step and rebuild the event buffer. */
+    void endStep();
+
+    /** Events of the last completed step: Begin/Persist first in key order, then End. */
+    const std::vector<contactEvent> &getEvents() const;
+
+    /** Number of pairs touching in the last completed step (Begin + Persist). */
+    size_t activeContacts() const;
+};
+#endif // contactEvents_h
@@ -0,0 +1,27 @@
+// diagnostics: per-step conservation and contact-quality metrics.
+/**
+ * @brief Optional diagnostics stage (toggle with F3 or `diagnosticsEnabled`).
+ * Nothing here runs a pass of its own: energy and momentum are reduced inside the parallel
+ * integration pass (physicsEffects::applyGravity), the N-body potential inside the Barnes–Hut
+ * pass (physicsEffects::applyMutualGravity) and penetration inside the collision pass,
+ * using per-worker partials that are summed once at the end of each pass.
+ */
+#ifndef diagnostics_h
+#define diagnostics_h
+
+struct stepDiagnostics {
+    double kineticEnergy{0.0};   ///< sum of 0.5 * m * |v|^2 after integration
+    double potentialEnergy{0.0}; ///< m * g * (floor - y) summed in the uniform field; -G * m_i * m_j / r over pairs (Barnes–Hut) in N-body mode
+    double momentumX{0.0};       ///< sum of m * v
+    double momentumY{0.0};
+    double maxPenetration{0.0};  ///< deepest overlap seen by the collision pass (pixels)
+    double meanPenetration{0.0}; ///< mean overlap over touching pairs (pixels)
+    int contactCount{0};         ///< touching pairs this step
+    int pairsPruned{0};          ///< candidate pairs rejected by collision layers / masks (first pass)
+    int staticBodies{0};         ///< bodies in staticGrid
+    int staticRebuilds{0};       ///< staticGrid rebuilds since start (only when the static set changed)
+    int bodies{0};
+
+    double totalEnergy() const { return kineticEnergy + potentialEnergy; }
+};
+#endif // diagnostics_h
@@ -0,0 +1,130 @@
+// frameBudget implementation: smoothed per-phase costs, hysteresis, and knob stepping with audit logging.
+
+#include "frameBudget.h"
+#include "config.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cmath>
+
+frameBudget::frameBudget(const char *name, double budgetMs) : name(name), budgetMs(budgetMs) {}
+
+int frameBudget::addPhase(const char *phaseName){
+    phases.push_back(budgetPhase{phaseName});
+    return static_cast<int>(phases.size()) - 1;
+}
+
+int frameBudget::addKnob(const char *knobName, int phase, double best, double cheapest, double step){
+    return addKnob(knobName, phase, best, cheapest, step, best);
+}
+
+int frameBudget::addKnob(const char *knobName, int phase, double best, double cheapest, double step, double start){
+    knobs.push_back(budgetKnob{knobName, phase, best, cheapest, std::abs(step), start});
+    return static_cast<int>(knobs.size()) - 1;
+}
+
+void frameBudget::record(int phase, double ms){
+    phases[phase].lastMs += ms;
+}
+
+bool frameBudget::update(){
+    // Exponential smoothing: one slow frame (GC-like hiccup, window resize) must not cost quality.
+    const double alpha = BUDGET_SMOOTHING;
+    double total = 0.0;
+    for (budgetPhase &phase : phases) {
+        phase.smoothedMs += alpha * (phase.lastMs - phase.smoothedMs);
+        phase.lastMs = 0.0;
+        total += phase.smoothedMs;
+    }
+    if (!enabled) return false;
+
+    overFrames = total > budgetMs ? overFrames + 1 : 0;
+    underFrames = total < budgetMs * BUDGET_RECOVER_SHARE ? underFrames + 1 : 0;
+    if (overFrames >= BUDGET_DEGRADE_FRAMES) {
+        overFrames = 0; // the next decision waits for a full window measured with the new setting
+        return degrade();
+    }
+    if (underFrames >= BUDGET_RECOVER_FRAMES) {
+        underFrames = 0;
+        return recover();
+    }
+    return false;
+}
+
+bool frameBudget::degrade(){
+    // Cheapen the knob behind the most expensive phase that still has room.
+    int chosen = -1;
+    for (int k = 0; k < static_cast<int>(knobs.size()); ++k) {
+        const budgetKnob &knob = knobs[k];
+        if (knob.value == knob.cheapest) continue;
+        if (chosen < 0 || phases[knob.phase].smoothedMs > phases[knobs[chosen].phase].smoothedMs) chosen = k;
+    }
+    if (chosen < 0) {
+        if (!saturated) {
+            TraceLog(LOG_WARNING, "BUDGET %s: %.2f ms over %.2f ms budget, every knob already at its cheapest",
+                     name.c_str(), smoothedMs(), budgetMs);
+        }
+        saturated = true;
+        return false;
+    }
+    budgetKnob &knob = knobs[chosen];
+    double from = knob.value;
+    double direction = knob.cheapest > knob.best ? 1.0 : -1.0;
+    knob.value += direction * knob.step;
+    if ((knob.value - knob.cheapest) * direction > 0.0) knob.value = knob.cheapest;
+    degraded.push_back(chosen);
+    logDecision("degrade", knob, from, phases[knob.phase].smoothedMs);
+    return true;
+}
+
+bool frameBudget::recover(){
+    const char *action = "recover";
+    int chosen = -1;
+    if (!degraded.empty()) {
+        chosen = degraded.back();
+        degraded.pop_back();
+    } else {
+        // Nothing to give back: spend the headroom on a knob that was registered below its best.
+        for (int k = 0; k < static_cast<int>(knobs.size()) && chosen < 0; ++k) {
+            if (knobs[k].value != knobs[k].best) chosen = k;
+        }
+        if (chosen < 0) return false;
+        action = "raise";
+    }
+    saturated = false;
+    budgetKnob &knob = knobs[chosen];
+    double from = knob.value;
+    double direction = knob.best > knob.cheapest ? 1.0 : -1.0;
+    knob.value += direction * knob.step;
+    if ((knob.value - knob.best) * direction > 0.0) knob.value = knob.best;
+    logDecision(action, knob, from, phases[knob.phase].smoothedMs);
+    return true;
+}
+
+void frameBudget::logDecision(const char *action, const budgetKnob &knob, double from, double phaseMs) const {
+    TraceLog(LOG_INFO, "BUDGET %s: %s %s %g -> %g (total %.2f ms, budget %.2f ms, %s %.2f ms)", name.c_str(),
+             action, knob.name.c_str(), from, knob.value, smoothedMs(), budgetMs,
+             phases[knob.phase].name.c_str(), phaseMs);
+}
+
+double frameBudget::value(int knob) const {
+    return knobs[knob].value;
+}
+
+double frameBudget::smoothedMs() const {
+    double total = 0.0;
+    for (const budgetPhase &phase : phases) total += phase.smoothedMs;
+    return total;
+}
+
+double frameBudget::getBudgetMs() const {
+    return budgetMs;
+}
+
+void frameBudget::setEnabled(bool status){
+    enabled = status;
+    overFrames = underFrames = 0;
+}
+
+bool frameBudget::isEnabled() const {
+    return enabled;
+}
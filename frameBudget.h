@@ -0,0 +1,74 @@
+// frameBudget: keeps a loop within a per-frame millisecond budget by trading quality knobs for time.
+/**
+ * @brief Adaptive quality controller (one instance per loop; not thread-safe).
+ * - The owner record()s the cost of each phase every frame and calls update() once at its end.
+ * - Phase costs are smoothed; when the smoothed total stays over budget for BUDGET_DEGRADE_FRAMES
+ *   frames, one notch is taken off the knob driven by the most expensive phase. When it stays
+ *   under BUDGET_RECOVER_SHARE of the budget for BUDGET_RECOVER_FRAMES frames, the most recently
+ *   degraded knob gets one notch back; with nothing left to give back, a knob registered below its
+ *   best value is raised one notch instead (quality it only gets while there is headroom).
+ * - Knobs move between a best-quality and a cheapest value set at registration; the owner reads
+ *   value() and applies it. Every decision is logged with TraceLog for auditing.
+ */
+#ifndef frameBudget_h
+#define frameBudget_h
+#include <string>
+#include <vector>
+
+class frameBudget {
+    private:
+    struct budgetPhase {
+        std::string name;
+        double lastMs{0.0};
+        double smoothedMs{0.0};
+    };
+    struct budgetKnob {
+        std::string name;
+        int phase;       // phase whose cost this knob mainly drives
+        double best;     // full-quality end of the range
+        double cheapest; // cheapest end of the range
+        double step;     // change per decision (positive)
+        double value;
+    };
+    std::string name;
+    double budgetMs;
+    bool enabled{true};
+    std::vector<budgetPhase> phases;
+    std::vector<budgetKnob> knobs;
+    std::vector<int> degraded; // knob index per notch taken, most recent last
+    int overFrames{0};
+    int underFrames{0};
+    bool saturated{false}; // over budget with every knob at its cheapest (logged once per episode)
+    bool degrade();
+    bool recover();
+    void logDecision(const char *action, const budgetKnob &knob, double from, double phaseMs) const;
+    public:
+    frameBudget(const char *name, double budgetMs);
+
+    /** Register a measured phase; returns its id for record(). */
+    int addPhase(const char *phaseName);
+
+    /** Register a knob tied to `phase`, starting at `best`; returns its id for value(). */
+    int addKnob(const char *knobName, int phase, double best, double cheapest, double step);
+
+    /** As above, but starting at `start`; the knob climbs toward `best` only on sustained headroom. */
+    int addKnob(const char *knobName, int phase, double best, double cheapest, double step, double start);
+
+    /** Cost of `phase` in the current frame (accumulates if recorded more than once). */
+    void record(int phase, double ms);
+
+    /** Close the frame: smooth the costs and move at most one knob. Returns true if a knob changed. */
+    bool update();
+
+    /** Current setting of `knob`. */
+    double value(int knob) const;
+
+    /** Smoothed total cost of the recorded phases. */
+    double smoothedMs() const;
+    double getBudgetMs() const;
+
+    /** A disabled controller still measures but leaves every knob where it is. */
+    void setEnabled(bool status);
+    bool isEnabled() const;
+};
+#endif // frameBudget_h
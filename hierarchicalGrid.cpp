@@ -0,0 +1,175 @@
+// hierarchicalGrid implementation: histogram-driven level selection and sorted, hashed cells per level.
+
+#include "hierarchicalGrid.h"
+#include "config.h"
+#include <algorithm>
+#include <cstdint>
+
+uint64_t hierarchicalGrid::cellKey(int cx, int cy){
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+}
+
+static uint64_t hashKey(uint64_t key){
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key;
+}
+
+void hierarchicalGrid::build(const quadItem *source, int count, const collisionFilter *itemFilters){
+    items.assign(source, source + count);
+    if (itemFilters) {
+        filters.assign(itemFilters, itemFilters + count);
+    } else {
+        filters.clear();
+    }
+    chooseLevels();
+    for (int l = 0; l < static_cast<int>(levels.size()); ++l) buildLevel(l);
+}
+
+void hierarchicalGrid::chooseLevels(){
+    levels.clear();
+    itemLevel.assign(items.size(), 0);
+    if (items.empty()) return;
+
+    // Histogram over power-of-two radius classes above the smallest live radius.
+    float minRadius = items[0].radius, maxRadius = items[0].radius;
+    for (const quadItem &item : items) {
+        minRadius = std::min(minRadius, item.radius);
+        maxRadius = std::max(maxRadius, item.radius);
+    }
+    minRadius = std::max(minRadius, 0.5f);
+    auto radiusClass = [minRadius](float radius) {
+        int c = static_cast<int>(std::floor(std::log2(std::max(radius, minRadius) / minRadius)));
+        return std::min(c, 31);
+    };
+    int classes = radiusClass(maxRadius) + 1;
+    std::vector<int> histogram(classes, 0);
+    std::vector<float> classMax(classes, 0.0f);
+    for (const quadItem &item : items) {
+        int c = radiusClass(item.radius);
+        ++histogram[c];
+        classMax[c] = std::max(classMax[c], item.radius);
+    }
+
+    // Walk classes fine to coarse, closing a level once it holds enough bodies to be worth its own grid.
+    // Sparse classes are folded upward (a coarser cell is always safe, only less selective).
+    int minShare = std::max(1, static_cast<int>(items.size() * HGRID_MIN_LEVEL_SHARE));
+    std::vector<int> classToLevel(classes, 0);
+    int accumulated = 0;
+    float levelMax = 0.0f;
+    for (int c = 0; c < classes; ++c) {
+        accumulated += histogram[c];
+        levelMax = std::max(levelMax, classMax[c]);
+        classToLevel[c] = static_cast<int>(levels.size());
+        bool last = c == classes - 1;
+        bool full = accumulated >= minShare && static_cast<int>(levels.size()) < HGRID_MAX_LEVELS - 1;
+        if ((full || last) && accumulated > 0) {
+            gridLevel level;
+            level.maxRadius = levelMax;
+            level.cellSize = std::max(2.0f * levelMax, 1.0f);
+            level.invCellSize = 1.0f / level.cellSize;
+            levels.push_back(std::move(level));
+            accumulated = 0;
+            levelMax = 0.0f;
+        }
+    }
+    for (size_t i = 0; i < items.size(); ++i) {
+        itemLevel[i] = static_cast<unsigned char>(classToLevel[radiusClass(items[i].radius)]);
+    }
+}
+
+void hierarchicalGrid::buildLevel(int l){
+    gridLevel &level = levels[l];
+    scratch.clear();
+    for (int i = 0; i < static_cast<int>(items.size()); ++i) {
+        if (itemLevel[i] != l) continue;
+        int cx = static_cast<int>(std::floor(items[i].x * level.invCellSize));
+        int cy = static_cast<int>(std::floor(items[i].y * level.invCellSize));
+        scratch.emplace_back(cellKey(cx, cy), i);
+    }
+    std::sort(scratch.begin(), scratch.end());
+
+    level.order.resize(scratch.size());
+    level.cells.clear();
+    for (int s = 0; s < static_cast<int>(scratch.size()); ++s) {
+        level.order[s] = scratch[s].second;
+        if (level.cells.empty() || level.cells.back().key != scratch[s].first) {
+            level.cells.push_back(gridCell{scratch[s].first, s, 0});
+        }
+        ++level.cells.back().count;
+    }
+
+    // Open-addressing table at <= 50% load.
+    size_t tableSize = 16;
+    while (tableSize < level.cells.size() * 2) tableSize <<= 1;
+    level.table.assign(tableSize, -1);
+    level.tableMask = tableSize - 1;
+    for (int c = 0; c < static_cast<int>(level.cells.size()); ++c) {
+        uint64_t h = hashKey(level.cells[c].key) & level.tableMask;
+        while (level.table[h] >= 0) h = (h + 1) & level.tableMask;
+        level.table[h] = c;
+    }
+
+    // Occupancy bitmap when it costs at most HGRID_OCCUPANCY_BITS_PER_CELL bits per occupied cell.
+    level.occupied.clear();
+    if (level.cells.empty()) return;
+    int minCx = INT32_MAX, minCy = INT32_MAX, maxCx = INT32_MIN, maxCy = INT32_MIN;
+    for (const gridCell &cell : level.cells) {
+        int cx = static_cast<int>(static_cast<int32_t>(cell.key >> 32));
+        int cy = static_cast<int>(static_cast<int32_t>(cell.key & 0xFFFFFFFFu));
+        minCx = std::min(minCx, cx);
+        maxCx = std::max(maxCx, cx);
+        minCy = std::min(minCy, cy);
+        maxCy = std::max(maxCy, cy);
+    }
+    int64_t spanX = static_cast<int64_t>(maxCx) - minCx + 1, spanY = static_cast<int64_t>(maxCy) - minCy + 1;
+    if (spanX * spanY > static_cast<int64_t>(level.cells.size()) * HGRID_OCCUPANCY_BITS_PER_CELL) return;
+    level.minCx = minCx;
+    level.minCy = minCy;
+    level.spanX = static_cast<int>(spanX);
+    level.spanY = static_cast<int>(spanY);
+    level.occupied.assign(static_cast<size_t>((spanX * spanY + 63) / 64), 0);
+    for (const gridCell &cell : level.cells) {
+        int cx = static_cast<int>(static_cast<int32_t>(cell.key >> 32)) - minCx;
+        int cy = static_cast<int>(static_cast<int32_t>(cell.key & 0xFFFFFFFFu)) - minCy;
+        size_t bit = static_cast<size_t>(cy) * level.spanX + cx;
+        level.occupied[bit >> 6] |= uint64_t{1} << (bit & 63);
+    }
+}
+
+const hierarchicalGrid::gridCell *hierarchicalGrid::findCell(const gridLevel &level, int cx, int cy) const {
+    if (level.cells.empty()) return nullptr;
+    if (!level.occupied.empty()) {
+        // Unsigned compare also rejects cells below the minimum.
+        uint64_t x = static_cast<uint64_t>(static_cast<int64_t>(cx) - level.minCx);
+        uint64_t y = static_cast<uint64_t>(static_cast<int64_t>(cy) - level.minCy);
+        if (x >= static_cast<uint64_t>(level.spanX) || y >= static_cast<uint64_t>(level.spanY)) return nullptr;
+        size_t bit = static_cast<size_t>(y) * level.spanX + x;
+        if (!(level.occupied[bit >> 6] & (uint64_t{1} << (bit & 63)))) return nullptr;
+    }
+    uint64_t key = cellKey(cx, cy);
+    uint64_t h = hashKey(key) & level.tableMask;
+    while (level.table[h] >= 0) {
+        const gridCell &cell = level.cells[level.table[h]];
+        if (cell.key == key) return &cell;
+        h = (h + 1) & level.tableMask;
+    }
+    return nullptr;
+}
+
+int hierarchicalGrid::itemCount() const {
+    return static_cast<int>(items.size());
+}
+
+int hierarchicalGrid::levelCount() const {
+    return static_cast<int>(levels.size());
+}
+
+float hierarchicalGrid::levelCellSize(int level) const {
+    return levels[level].cellSize;
+}
+
+int hierarchicalGrid::levelItemCount(int level) const {
+    return static_cast<int>(levels[level].order.size());
+}
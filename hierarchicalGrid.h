@@ -0,0 +1,205 @@
+// hierarchicalGrid: multi-level uniform grid broadphase for bodies with widely mixed radii.
+/**
+ * @brief Buckets each body into one level by radius class and one cell by center.
+ * - Level sizes come from the live radius histogram each build: radii are grouped into power-of-two
+ *   classes above the smallest radius, sparse classes are merged upward, and each level's cell size is
+ *   twice the largest radius actually present in it. Small bodies never share cells with big ones.
+ * - Same-level pairs only look at the body's own cell and half of its 8 neighbours; cross-level pairs
+ *   are only tested from the finer body into coarser levels, so each pair is visited once.
+ * - Cells are found through a per-level open-addressing hash of (cellX, cellY), so the world is unbounded;
+ *   a per-level occupancy bitmap answers most empty-cell lookups first when the level's bounds are compact.
+ * - Optional per-item collisionFilter (layer / mask bits): pairs that cannot collide are rejected before
+ *   their bounding boxes are compared, and counted as pruned.
+ */
+#ifndef hierarchicalGrid_h
+#define hierarchicalGrid_h
+#include "quadTree.h"
+#include "config.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/** Collision layer bits of a body and the layers it collides with. */
+struct collisionFilter {
+    uint32_t layer{LAYER_DEFAULT};
+    uint32_t mask{LAYER_ALL};
+};
+
+/** True when each body's layer is accepted by the other's mask. */
+inline bool filtersCollide(const collisionFilter &a, const collisionFilter &b){
+    return (a.layer & b.mask) != 0 && (b.layer & a.mask) != 0;
+}
+
+class hierarchicalGrid {
+    private:
+    struct gridCell {
+        uint64_t key;
+        int start; // range into gridLevel::order
+        int count;
+    };
+    struct gridLevel {
+        float cellSize{0.0f};
+        float invCellSize{0.0f};
+        float maxRadius{0.0f};
+        std::vector<int> order;        // item indices sorted by cell key
+        std::vector<gridCell> cells;
+        std::vector<int> table;        // hash slot -> index into cells, -1 when empty
+        uint64_t tableMask{0};
+        // Occupancy bits over the level's cell bounds, when they are compact enough: most lookups
+        // of empty cells (probes around sparse static geometry) end here without touching the table.
+        std::vector<uint64_t> occupied;
+        int minCx{0}, minCy{0}, spanX{0}, spanY{0};
+    };
+    std::vector<quadItem> items;
+    std::vector<collisionFilter> filters; // parallel to items; empty when built without filters
+    std::vector<unsigned char> itemLevel;
+    std::vector<gridLevel> levels;
+    std::vector<std::pair<uint64_t, int>> scratch; // (cell key, item) pairs while sorting a level
+
+    static uint64_t cellKey(int cx, int cy);
+    void chooseLevels();
+    void buildLevel(int level);
+    const gridCell *findCell(const gridLevel &level, int cx, int cy) const;
+    public:
+    hierarchicalGrid() = default;
+
+    /** Rebuild levels and cells over `count` items (copied), with optional per-item filters (copied). */
+    void build(const quadItem *source, int count, const collisionFilter *itemFilters = nullptr);
+
+    int itemCount() const;
+
+    int levelCount() const;
+    float levelCellSize(int level) const;
+    int levelItemCount(int level) const;
+
+    /**
+     * @brief Call f(slotA, slotB) once for each pair of items whose bounding boxes overlap.
+     * Same contract as quadTree::forEachCandidatePair, so the two are interchangeable.
+     * Returns the number of pairs rejected by the filters (0 when built without them).
+     */
+    template <typename F>
+    int forEachCandidatePair(F &&f) const;
+
+    /**
+     * @brief Call f(slot) for each item whose bounding box overlaps `probe` and whose filter collides
+     * with `probeFilter` (probing one structure with bodies of another). Returns the number rejected by the filters.
+     */
+    template <typename F>
+    int forEachOverlap(const quadItem &probe, const collisionFilter &probeFilter, F &&f) const;
+
+    /**
+     * @brief Call f(slotHere, slotThere) for each item here whose bounding box overlaps an item of `other`
+     * and whose filters collide. Items are probed in cell order, so consecutive probes touch the same
+     * cells of `other`. Returns the number rejected by the filters.
+     */
+    template <typename F>
+    int forEachPairWith(const hierarchicalGrid &other, F &&f) const;
+};
+
+inline bool boxesOverlap(const quadItem &a, const quadItem &b){
+    return !(a.x + a.radius < b.x - b.radius || a.x - a.radius > b.x + b.radius ||
+             a.y + a.radius < b.y - b.radius || a.y - a.radius > b.y + b.radius);
+}
+
+template <typename F>
+int hierarchicalGrid::forEachCandidatePair(F &&f) const {
+    // Filter bits are checked before any geometry.
+    const bool filtered = !filters.empty();
+    int pruned = 0;
+    auto visit = [&](int ia, int ib) {
+        if (filtered && !filtersCollide(filters[ia], filters[ib])) {
+            ++pruned;
+            return;
+        }
+        const quadItem &a = items[ia];
+        const quadItem &b = items[ib];
+        if (boxesOverlap(a, b)) f(a.slot, b.slot);
+    };
+    // Forward half of the 8-neighbourhood: each unordered pair of cells is visited once.
+    static const int forward[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+    for (int l = 0; l < static_cast<int>(levels.size()); ++l) {
+        const gridLevel &level = levels[l];
+        for (const gridCell &cell : level.cells) {
+            int cx = static_cast<int>(static_cast<int32_t>(cell.key >> 32));
+            int cy = static_cast<int>(static_cast<int32_t>(cell.key & 0xFFFFFFFFu));
+            for (int s = cell.start; s < cell.start + cell.count; ++s) {
+                for (int t = s + 1; t < cell.start + cell.count; ++t) visit(level.order[s], level.order[t]);
+            }
+            for (const auto &offset : forward) {
+                const gridCell *other = findCell(level, cx + offset[0], cy + offset[1]);
+                if (!other) continue;
+                for (int s = cell.start; s < cell.start + cell.count; ++s) {
+                    for (int t = other->start; t < other->start + other->count; ++t) visit(level.order[s], level.order[t]);
+                }
+            }
+        }
+
+        // Small-vs-large: look up from this level into every coarser one.
+        for (int m = l + 1; m < static_cast<int>(levels.size()); ++m) {
+            const gridLevel &coarse = levels[m];
+            for (int s = 0; s < static_cast<int>(level.order.size()); ++s) {
+                const quadItem &a = items[level.order[s]];
+                float reach = a.radius + coarse.maxRadius;
+                int x0 = static_cast<int>(std::floor((a.x - reach) * coarse.invCellSize));
+                int x1 = static_cast<int>(std::floor((a.x + reach) * coarse.invCellSize));
+                int y0 = static_cast<int>(std::floor((a.y - reach) * coarse.invCellSize));
+                int y1 = static_cast<int>(std::floor((a.y + reach) * coarse.invCellSize));
+                for (int cy = y0; cy <= y1; ++cy) {
+                    for (int cx = x0; cx <= x1; ++cx) {
+                        const gridCell *other = findCell(coarse, cx, cy);
+                        if (!other) continue;
+                        for (int t = other->start; t < other->start + other->count; ++t) {
+                            visit(level.order[s], coarse.order[t]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return pruned;
+}
+
+template <typename F>
+int hierarchicalGrid::forEachOverlap(const quadItem &probe, const collisionFilter &probeFilter, F &&f) const {
+    const bool filtered = !filters.empty();
+    int pruned = 0;
+    for (const gridLevel &level : levels) {
+        float reach = probe.radius + level.maxRadius;
+        int x0 = static_cast<int>(std::floor((probe.x - reach) * level.invCellSize));
+        int x1 = static_cast<int>(std::floor((probe.x + reach) * level.invCellSize));
+        int y0 = static_cast<int>(std::floor((probe.y - reach) * level.invCellSize));
+        int y1 = static_cast<int>(std::floor((probe.y + reach) * level.invCellSize));
+        for (int cy = y0; cy <= y1; ++cy) {
+            for (int cx = x0; cx <= x1; ++cx) {
+                const gridCell *cell = findCell(level, cx, cy);
+                if (!cell) continue;
+                for (int t = cell->start; t < cell->start + cell->count; ++t) {
+                    int index = level.order[t];
+                    if (filtered && !filtersCollide(probeFilter, filters[index])) {
+                        ++pruned;
+                        continue;
+                    }
+                    if (boxesOverlap(probe, items[index])) f(items[index].slot);
+                }
+            }
+        }
+    }
+    return pruned;
+}
+
+template <typename F>
+int hierarchicalGrid::forEachPairWith(const hierarchicalGrid &other, F &&f) const {
+    if (other.items.empty()) return 0;
+    const collisionFilter unfiltered;
+    int pruned = 0;
+    for (const gridLevel &level : levels) {
+        for (int index : level.order) {
+            const quadItem &probe = items[index];
+            pruned += other.forEachOverlap(probe, filters.empty() ? unfiltered : filters[index],
+                                           [&](int slot) { f(probe.slot, slot); });
+        }
+    }
+    return pruned;
+}
+#endif // hierarchicalGrid_h
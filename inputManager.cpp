@@ -1,5 +1,5 @@
 // inputManager implementation: converts keyboard state into per-entity velocity updates.
-// Notes: uses dt = GetFrameTime(); WALK_SPEED/FLYSPEED treated as per-second accelerations/impulses.
+// Notes: dt is the simulation step; WALK_SPEED/FLYSPEED treated as per-second accelerations/impulses.
 
 #include "Entity.h"
 #include "raylib.h"
@@ -12,136 +12,242 @@
 
 
 void inputManager::addToEntityList(Entity *entity){
-    if (std::find(entity_ptr.begin(), entity_ptr.end(), entity) != entity_ptr.end()) {
-        return; // already in list
+    // Indexed by pool slot, like physicsEffects.
+    size_t slot = static_cast<size_t>(entity->get_id());
+    if (slot >= entity_ptr.size()) entity_ptr.resize(slot + 1, nullptr);
+    entity_ptr[slot] = entity;
+    if (entity->getCanMove()) trackControllable(entity);
+}
+void inputManager::addRangeToEntityList(Entity *const *entities, size_t count){
+    for (size_t i = 0; i < count; ++i) addToEntityList(entities[i]);
+}
+void inputManager::removeFromEntityList(Entity *entity) {
+    size_t slot = static_cast<size_t>(entity->get_id());
+    if (slot < entity_ptr.size() && entity_ptr[slot] == entity) entity_ptr[slot] = nullptr;
+    const int id = entity->get_id();
+    controllable.erase(std::remove_if(controllable.begin(), controllable.end(),
+                                      [id](const entityHandle &handle) { return handle.slot == id; }),
+                       controllable.end());
+}
+void inputManager::trackControllable(Entity *entity){
+    // The list holds a handful of entries, so a linear search keeps it free of duplicates.
+    const entityHandle handle = handleOf(entity->get_id());
+    for (const entityHandle &known : controllable) {
+        if (known.slot == handle.slot && known.generation == handle.generation) return;
     }
-    if (auto it = std::find(entity_ptr.begin(), entity_ptr.end(), nullptr); it != entity_ptr.end()) {
-        *it = entity; // added in empty slot
-        return;
+    controllable.push_back(handle);
+}
+void inputManager::setControllable(Entity *entity, bool status){
+    entity->setCanMove(status);
+    if (status) trackControllable(entity); // entries that lost canMove are dropped by processInputs
+}
+void inputManager::refreshControllable(){
+    controllable.clear();
+    for (Entity *entity : entity_ptr) {
+        if (entity && entity->getCanMove()) trackControllable(entity);
     }
-    // If we reach here, no empty slot was found; add to the end
-    entity_ptr.push_back(entity);
 }
-void inputManager::removeFromEntityList(Entity *entity) {
-    entity_ptr.erase(std::remove(entity_ptr.begin(), entity_ptr.end(), entity), entity_ptr.end());
+// Bit positions for the keys the simulation reacts to; captureInputs() maps raylib keys onto them.
+enum inputKey : uint32_t {
+    INPUT_W = 1u << 0,
+    INPUT_A = 1u << 1,
+    INPUT_S = 1u << 2,
+    INPUT_D = 1u << 3,
+    INPUT_SPACE = 1u << 4,
+    INPUT_EQUAL = 1u << 5,
+    INPUT_MINUS = 1u << 6,
+    INPUT_DELETE = 1u << 7,
+    INPUT_B = 1u << 8,
+    INPUT_E = 1u << 9,
+    INPUT_T = 1u << 10,
+    INPUT_P = 1u << 11,
+    INPUT_K = 1u << 12,
+};
+static const struct { int raylibKey; uint32_t bit; } inputKeyMap[] = {
+    {KEY_W, INPUT_W}, {KEY_A, INPUT_A}, {KEY_S, INPUT_S}, {KEY_D, INPUT_D},
+    {KEY_SPACE, INPUT_SPACE}, {KEY_EQUAL, INPUT_EQUAL}, {KEY_MINUS, INPUT_MINUS},
+    {KEY_DELETE, INPUT_DELETE}, {KEY_B, INPUT_B}, {KEY_E, INPUT_E}, {KEY_T, INPUT_T}, {KEY_P, INPUT_P},
+    {KEY_K, INPUT_K},
+};
+
+bool inputManager::keyDown(uint32_t key) const {
+    return (keysDown.load(std::memory_order_relaxed) & key) != 0;
 }
-void inputManager::processInputs(){
-    float dt = GetFrameTime();
-    // Iterate over a snapshot to avoid iterator invalidation if `SpawnEntity`
-    // or other calls modify `entity_ptr` during processing.
-    std::vector<Entity*> snapshot = entity_ptr;
-    for (Entity *entity : snapshot) {
-        if (!entity) continue;
-        if (!entity->getCanMove()) continue;
 
-        // Horizontal: apply acceleration scaled by 1/mass and clamped to MAX_WALK_SPEED.
-        if (IsKeyDown(KEY_A) && IsKeyDown(KEY_D)) {
-            entity->set_vx(0.0);
+void inputManager::captureInputs(){
+    uint32_t down = 0;
+    uint32_t pressed = 0;
+    for (const auto &mapping : inputKeyMap) {
+        if (IsKeyDown(mapping.raylibKey)) down |= mapping.bit;
+        if (IsKeyPressed(mapping.raylibKey)) pressed |= mapping.bit;
+    }
+    keysDown.store(down, std::memory_order_relaxed);
+    // OR presses in so a press is not lost when several render frames pass between simulation steps.
+    keysPressed.fetch_or(pressed, std::memory_order_relaxed);
+    Vector2 mouse = GetMousePosition();
+    pointerX.store(mouse.x, std::memory_order_relaxed);
+    pointerY.store(mouse.y, std::memory_order_relaxed);
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        pointerClicked.store(true, std::memory_order_relaxed);
+    }
+
+    // World settings are atomics read by the simulation thread at the start of each step.
+    if (IsKeyPressed(KEY_N)) {
+        nbodyEnabled.store(!nbodyEnabled.load());
+    }
+    if (IsKeyPressed(KEY_F3)) {
+        diagnosticsEnabled.store(!diagnosticsEnabled.load());
+    }
+    if (IsKeyPressed(KEY_F4)) {
+        budgetEnabled.store(!budgetEnabled.load());
+    }
+    if (IsKeyPressed(KEY_H)) {
+        historyEnabled.store(!historyEnabled.load());
+    }
+    if (IsKeyPressed(KEY_LEFT_BRACKET)) {
+        nbodyTheta.store(std::max(0.1f, nbodyTheta.load() - 0.1f));
+    }
+    if (IsKeyPressed(KEY_RIGHT_BRACKET)) {
+        nbodyTheta.store(std::min(2.0f, nbodyTheta.load() + 0.1f));
+    }
+
+    // Window keys act on raylib state and must stay on the main thread.
+    if (IsKeyPressed(KEY_F)) {
+        // Toggle fullscreen OR toggle borderless windowed mode (separately)
+        static bool borderless = false;
+        // Toggle fullscreen first if desired (uncomment if you want fullscreen toggle)
+        // ToggleFullscreen();
+
+        // Toggle borderless windowed mode without forcing it every frame
+        borderless = !borderless;
+        if (borderless) {
+            SetWindowState(FLAG_BORDERLESS_WINDOWED_MODE);
+        } else {
+            ClearWindowState(FLAG_BORDERLESS_WINDOWED_MODE);
         }
-        else if (IsKeyDown(KEY_D)) {
-            double mass = entity->getWeight(); if (mass <= 0.0) mass = 1.0;
-            entity->addToVx((WALK_SPEED / mass) * dt);
-            if (entity->get_vx() > MAX_WALK_SPEED) {
-                entity->set_vx(MAX_WALK_SPEED);
+    }
+    if (IsKeyPressed(KEY_V)) {
+        int width[] = {1280,1920,2560,3840};
+        int height[] = {720,1080,1440,2160};
+        int monW = GetMonitorWidth(GetCurrentMonitor());
+        int monH = GetMonitorHeight(GetCurrentMonitor());
+        for (size_t i = 0; i < 4; ++i) {
+            if (GetScreenWidth() == width[i] && GetScreenHeight() == height[i]) {
+                int newIndex = (i + 1) % 4;
+                // Only change if the next resolution fits the current monitor
+                if (width[newIndex] <= monW && height[newIndex] <= monH) {
+                    SetWindowSize(width[newIndex], height[newIndex]);
+                }
+                if (newIndex == 0 && (monW < width[0] || monH < height[0])) {
+                    // If even the smallest resolution doesn't fit, set to monitor size
+                    SetWindowSize(monW, monH);
+                }
+                break;
             }
         }
-        else if (IsKeyDown(KEY_A)) {
-            double mass = entity->getWeight(); if (mass <= 0.0) mass = 1.0;
-            entity->addToVx((-WALK_SPEED / mass) * dt);
-            if (entity->get_vx() < -MAX_WALK_SPEED) {
-                entity->set_vx(-MAX_WALK_SPEED);
-            }
+    }
+}
+
+void inputManager::processInputs(double dt){
+    uint32_t pressed = keysPressed.exchange(0, std::memory_order_relaxed);
+    auto keyPressed = [pressed](uint32_t key) { return (pressed & key) != 0; };
+    // Only the controllable entities are visited, not the whole pool. Every change is queued as an
+    // entity command and applied by the drain that follows this call, so the list cannot change while
+    // it is iterated here. Steering is queued as an impulse (a velocity delta), so it adds to impulses
+    // from other producers in the same drain instead of overwriting them.
+    controllable.erase(std::remove_if(controllable.begin(), controllable.end(),
+                                      [](const entityHandle &handle) {
+                                          const Entity *entity = resolveHandle(handle);
+                                          return !entity || !entity->getCanMove();
+                                      }),
+                       controllable.end());
+    for (const entityHandle &handle : controllable) {
+        Entity *entity = resolveHandle(handle);
+        double mass = entity->getWeight(); if (mass <= 0.0) mass = 1.0;
+        const double startVx = entity->get_vx(), startVy = entity->get_vy();
+        double vx = startVx, vy = startVy;
+
+        // Horizontal: apply acceleration scaled by 1/mass and clamped to MAX_WALK_SPEED.
+        if (keyDown(INPUT_A) && keyDown(INPUT_D)) {
+            vx = 0.0;
+        }
+        else if (keyDown(INPUT_D)) {
+            vx = std::min(vx + (WALK_SPEED / mass) * dt, MAX_WALK_SPEED);
+        }
+        else if (keyDown(INPUT_A)) {
+            vx = std::max(vx - (WALK_SPEED / mass) * dt, -MAX_WALK_SPEED);
         }
 
         // Vertical movement: FLYSPEED/FALL_SPEED treated as accelerations (or forces that cancel mass)
-        if (IsKeyDown(KEY_W) && IsKeyDown(KEY_S)) {
+        if (keyDown(INPUT_W) && keyDown(INPUT_S)) {
             // no vertical input; gravity handled in physicsEffects
         }
-        else if (IsKeyDown(KEY_W)) {
-            double mass = entity->getWeight(); if (mass <= 0.0) mass = 1.0;
-            entity->addToVy((-FLYSPEED / mass) * dt);
-            if (entity->get_vy() < -MAX_FLY_SPEED) {
-                entity->set_vy(-MAX_FLY_SPEED);
-            }
+        else if (keyDown(INPUT_W)) {
+            vy = std::max(vy - (FLYSPEED / mass) * dt, -MAX_FLY_SPEED);
         }
-        else if (IsKeyDown(KEY_S)) {
-            double mass = entity->getWeight(); if (mass <= 0.0) mass = 1.0;
-            entity->addToVy((FALL_SPEED / mass) * dt);
-            if (entity->get_vy() > MAX_FALL_SPEED) {
-                entity->set_vy(MAX_FALL_SPEED);
-            }
+        else if (keyDown(INPUT_S)) {
+            vy = std::min(vy + (FALL_SPEED / mass) * dt, MAX_FALL_SPEED);
         }
         // Jumping: instant velocity impulse for simplicity (FLYSPEED interpreted as initial jump speed).
-        if (IsKeyPressed(KEY_SPACE)) {
-            if (entity->getOnGround()) {
-                double mass = entity->getWeight(); if (mass <= 0.0) mass = 1.0;
-                entity->set_vy(-FLYSPEED / mass); // instant jump impulse
-                entity->setOnGround(false);
-            }
+        // Boundary flags are cleared by the collision pass, so standing is taken from physics' support.
+        const bool jumping = keyPressed(INPUT_SPACE) && physics.isSupported(entity->get_id());
+        if (jumping) {
+            vy = -FLYSPEED / mass; // instant jump impulse
         }
         // When no horizontal input, apply damping using same friction semantics as physicsEffects.
-        if (entity->getCanMove() && !(IsKeyDown(KEY_D) || IsKeyDown(KEY_A))) {
+        if (!(keyDown(INPUT_D) || keyDown(INPUT_A))) {
             double decay = std::pow(static_cast<double>(FRICTION), static_cast<double>(dt));
-            entity->set_vx(entity->get_vx() * decay);
-             if (std::abs(entity->get_vx()) < 0.05){
-                 entity->set_vx(0.0);
-             }
-        }
-        if (IsKeyDown(KEY_EQUAL)) {
-            entity->set_radius(entity->get_radius() + 1.0);
-        }
-        if (IsKeyDown(KEY_MINUS)) {
-            entity->set_radius(entity->get_radius() - 1.0);
-        }
-        if (IsKeyDown(KEY_DELETE)) {
-            entity->markedForDeletionStatus(true);
+            vx *= decay;
+            if (std::abs(vx) < 0.05) {
+                vx = 0.0;
             }
-        if (!(IsKeyPressed(KEY_W) && IsKeyPressed(KEY_S) && IsKeyPressed(KEY_A) && IsKeyPressed(KEY_D))) {
-            entity->setStatic(true);
-        } 
-        else {
-            entity->setStatic(false);
         }
-        if (IsKeyPressed(KEY_B)) {
-            entity->setEntityBouncy(!entity->getEntityBouncy());
+        if (jumping || vx != startVx || vy != startVy) {
+            // Impulse = delta-v times the mass the drain divides by.
+            const double impulseMass = std::max(1.0, entity->getWeight());
+            const double jx = (vx - startVx) * impulseMass, jy = (vy - startVy) * impulseMass;
+            entityCommands.push(jumping ? entityCommand::jump(handle, jx, jy) : entityCommand::impulse(handle, jx, jy));
         }
-        if (IsKeyPressed(KEY_F)) {
-            // Toggle fullscreen OR toggle borderless windowed mode (separately)
-            static bool borderless = false;
-            // Toggle fullscreen first if desired (uncomment if you want fullscreen toggle)
-            // ToggleFullscreen();
-
-            // Toggle borderless windowed mode without forcing it every frame
-            borderless = !borderless;
-            if (borderless) {
-                SetWindowState(FLAG_BORDERLESS_WINDOWED_MODE);
-            } else {
-                ClearWindowState(FLAG_BORDERLESS_WINDOWED_MODE);
-            }
+        if (keyDown(INPUT_EQUAL)) {
+            // 1 px per 60 Hz frame, independent of step rate
+            entityCommands.push(entityCommand::resize(handle, entity->get_radius() + 60.0 * dt));
         }
-        if (IsKeyPressed(KEY_V)) {
-            int width[] = {1280,1920,2560,3840};
-            int height[] = {720,1080,1440,2160};
-            int monW = GetMonitorWidth(GetCurrentMonitor());
-            int monH = GetMonitorHeight(GetCurrentMonitor());
-            for (size_t i = 0; i < 4; ++i) {
-                if (GetScreenWidth() == width[i] && GetScreenHeight() == height[i]) {
-                    int newIndex = (i + 1) % 4;
-                    // Only change if the next resolution fits the current monitor
-                    if (width[newIndex] <= monW && height[newIndex] <= monH) {
-                        SetWindowSize(width[newIndex], height[newIndex]);
-                    }
-                    if (newIndex == 0 && (monW < width[0] || monH < height[0])) {
-                        // If even the smallest resolution doesn't fit, set to monitor size
-                        SetWindowSize(monW, monH);
-                    }
-                    break;
-                }
-            }
+        if (keyDown(INPUT_MINUS)) {
+            entityCommands.push(entityCommand::resize(handle, entity->get_radius() - 60.0 * dt));
         }
-        if ((IsKeyPressed(KEY_B))) {
-            SpawnEntity(entity->get_x() + 50, entity->get_y() + 50, entity->get_radius(), entity->getWeight(), entity->get_color(), 1);
+        if (keyDown(INPUT_DELETE)) {
+            entityCommands.push(entityCommand::remove(handle));
         }
+        if (keyPressed(INPUT_B)) {
+            entityCommands.push(entityCommand::setBouncy(handle, !entity->getEntityBouncy()));
+            entityCommands.push(entityCommand::spawn(entity->get_x() + 50, entity->get_y() + 50, entity->get_radius(),
+                                                     entity->getWeight(), entity->get_color()));
+        }
+    }
+    // Scripted behaviours (behaviours.h) go on the selection, or on the player when nothing is selected.
+    entityHandle handle = selected;
+    if (!resolveHandle(handle) && players[0]) handle = handleOf(0);
+    if (const Entity *target = resolveHandle(handle)) {
+        if (keyPressed(INPUT_E)) behaviours.start(emitterBehaviour(handle, EMITTER_INTERVAL_STEPS, EMITTER_COUNT));
+        if (keyPressed(INPUT_T)) behaviours.start(despawnBehaviour(handle, DESPAWN_DELAY_STEPS));
+        if (keyPressed(INPUT_P)) behaviours.start(patrolBehaviour(handle, PATROL_RANGE, PATROL_SPEED));
+        // Pin / unpin: static bodies are never integrated and live in their own broadphase (staticGrid).
+        if (keyPressed(INPUT_K)) entityCommands.push(entityCommand::setStatic(handle, !target->getEntityStatic()));
+    }
+}
+
+void inputManager::processPointer(const quadTree &tree){
+    hoveredSlot = tree.pick(pointerX.load(std::memory_order_relaxed), pointerY.load(std::memory_order_relaxed));
+    if (pointerClicked.exchange(false, std::memory_order_relaxed)) {
+        selected = hoveredSlot >= 0 ? handleOf(hoveredSlot) : entityHandle{};
     }
+}
 
-}
\ No newline at end of file
+int inputManager::getHovered() const {
+    return hoveredSlot;
+}
+
+int inputManager::getSelected() const {
+    // Checked like contact events: the generation must still match, not just the slot be occupied.
+    return resolveHandle(selected) ? selected.slot : -1;
+}
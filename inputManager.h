@@ -2,28 +2,71 @@
 /**
  * @brief The inputManager reads keyboard state and converts it into velocity/impulse updates.
  * - WALK_SPEED / FLYSPEED / FALL_SPEED are treated as accelerations or impulses per second.
- * - Must be called once per frame (processInputs()).
+ * - captureInputs() runs on the main (raylib) thread once per render frame and latches key state;
+ *   processInputs() runs on the simulation thread once per step and consumes the latched state.
  */
 #ifndef inputManager_h
 #define inputManager_h
 #include "Entity.h"
+#include "quadTree.h"
 #include "raylib.h"
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 class inputManager {
     private:
-     std::vector<Entity*> entity_ptr;
+     std::vector<Entity*> entity_ptr; // indexed by pool slot; nullptr when free
+     // Latched keyboard state written by captureInputs() (main thread) and read by processInputs() (sim thread).
+     std::atomic<uint32_t> keysDown{0};
+     std::atomic<uint32_t> keysPressed{0}; // accumulated presses since the last processInputs()
+     bool keyDown(uint32_t key) const;
+     // Latched mouse state; a click is kept until the simulation consumes it.
+     std::atomic<float> pointerX{-1.0f};
+     std::atomic<float> pointerY{-1.0f};
+     std::atomic<bool> pointerClicked{false};
+     std::vector<entityHandle> controllable; // entities with canMove, the only ones processInputs visits
+     void trackControllable(Entity *entity);
+     int hoveredSlot{-1};     // simulation thread only
+     entityHandle selected;   // simulation thread only; a handle, so a reused slot does not inherit the selection
     public:
     inputManager() = default;
 
-    /** Register a non-owning entity pointer (duplicates ignored). */
+    /** Register a non-owning entity pointer at its pool slot (O(1); re-registering is a no-op). */
     void addToEntityList(Entity *entity);
 
-    /** Unregister an entity pointer. */
+    /** Register a freshly spawned block of entity pointers. */
+    void addRangeToEntityList(Entity *const *entities, size_t count);
+
+    /** Unregister an entity pointer (clears its slot and drops it from the controllable list). */
     void removeFromEntityList(Entity *entity);
 
-    /** Read keyboard state and modify velocities/flags for registered entities (one call per frame). */
-    void processInputs();
+    /** Set whether `entity` (registered) follows player input; use this rather than Entity::setCanMove. */
+    void setControllable(Entity *entity, bool status);
+
+    /** Rebuild the controllable list from the registered entities (after a rewind rewrote the pool). */
+    void refreshControllable();
+
+    /**
+     * Sample raylib keyboard state and handle window-only keys (F, V). Main thread only,
+     * since raylib input and window calls are not thread-safe.
+     */
+    void captureInputs();
+
+    /** Apply latched input to registered entities' velocities/flags (one call per simulation step). */
+    void processInputs(double dt);
+
+    /**
+     * Resolve the latched mouse position against `tree`: update the hovered entity and, on a click,
+     * the selection (clicking empty space clears it). Simulation thread, after the tree is built.
+     */
+    void processPointer(const quadTree &tree);
+
+    /** Slot under the mouse, or -1. */
+    int getHovered() const;
+
+    /** Slot of the entity selected by the last click, or -1 (also once that entity has been released). */
+    int getSelected() const;
 };
 
 #endif // INPUTMANAGER_H
\ No newline at end of file
@@ -2,15 +2,25 @@
 // Key notes:
 //  - resolveCollision uses weight (or radius) as mass, clamps per-step positional correction, and avoids divide-by-zero by using deterministic jitter.
 //  - DetectCollison iterates valid pointers only and resets flags before collision pass.
+//  - Collision candidates are split by mobility: dynamic pairs from collisionGrid, dynamic-vs-static probes into staticGrid.
+//  - stepSimulation runs on the simulation thread (see simulation.h); main() only captures input and renders snapshots.
 #include "raylib.h"
 #include "Entity.h"
 #include "physicsEffects.h"
 #include "inputManager.h"
 #include "windowInteractions.h"
 #include "commands.h"
+#include "benchmarks.h"
+#include "frameBudget.h"
 #include "config.h"
+#include <algorithm>
 #include <ctime>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <vector>
 
 int width = 2560;
@@ -18,7 +28,9 @@ int height = 1300;
 
 // Pre-size the players vector to avoid out-of-bounds access on startup
 
-static void resolveCollision(Entity *a, Entity *b) {
+// Returns the impulse magnitude applied (0 if none) and writes the contact normal (from b towards a)
+// and the penetration depth found before positional correction.
+static double resolveCollision(Entity *a, Entity *b, double &normalX, double &normalY, double &penetration) {
   // Resolve interpenetration by moving objects proportionally to their "mass" (radius).
   // Then compute an impulse along the collision normal using a restitution coefficient.
   // Safety: handle zero-distance case by using relative velocity or deterministic jitter to avoid NaNs.
@@ -28,7 +40,10 @@ static void resolveCollision(Entity *a, Entity *b) {
 
   // penetration depth
   double overlap = (a->get_radius() + b->get_radius()) - dist;
-  if (overlap <= 0.0) return;
+  normalX = 0.0;
+  normalY = 0.0;
+  penetration = std::max(0.0, overlap);
+  if (overlap <= 0.0) return 0.0;
 
   // Normal (safe): handle degenerate zero-distance case with an epsilon
   const double eps = 1e-8;
@@ -61,6 +76,9 @@ static void resolveCollision(Entity *a, Entity *b) {
     dist = eps;
   }
 
+  normalX = nx;
+  normalY = ny;
+
   // Use `weight` as mass if available; fall back to radius as proxy.
   double ma_raw = a->getWeight() > 0.0 ? a->getWeight() : a->get_radius();
   double mb_raw = b->getWeight() > 0.0 ? b->getWeight() : b->get_radius();
@@ -86,6 +104,8 @@ static void resolveCollision(Entity *a, Entity *b) {
   if (moveA > maxPerBody) moveA = maxPerBody;
   if (moveB > maxPerBody) moveB = maxPerBody;
 
+  stepHistory.markChanged(a->get_id());
+  stepHistory.markChanged(b->get_id());
   a->set_x(a->get_x() + nx * moveA);
   a->set_y(a->get_y() + ny * moveA);
   b->set_x(b->get_x() - nx * moveB);
@@ -97,7 +117,7 @@ static void resolveCollision(Entity *a, Entity *b) {
   double velAlongNormal = rvx * nx + rvy * ny; // velocity along normal
 
   // If they're separating, do not apply impulse
-  if (velAlongNormal > 0.0) return;
+  if (velAlongNormal > 0.0) return 0.0;
 
   // Restitution (bounciness)
   double e = 0.6;
@@ -106,7 +126,7 @@ static void resolveCollision(Entity *a, Entity *b) {
   double invMa = a->getEntityStatic() ? 0.0 : (1.0 / ma);
   double invMb = b->getEntityStatic() ? 0.0 : (1.0 / mb);
   double denom = (invMa + invMb);
-  if (denom <= 0.0) return; // both static or invalid, skip impulse
+  if (denom <= 0.0) return 0.0; // both static or invalid, skip impulse
 
   double j = -(1.0 + e) * velAlongNormal;
   j /= denom;
@@ -116,90 +136,351 @@ static void resolveCollision(Entity *a, Entity *b) {
 
   if (!a->getEntityStatic()) { a->addToVx(jx * invMa); a->addToVy(jy * invMa); }
   if (!b->getEntityStatic()) { b->addToVx(-jx * invMb); b->addToVy(-jy * invMb); }
+  return j;
+}
+static bool circlesTouch(const Entity *a, const Entity *b){
+  // Positions may have moved since the grid was built (earlier resolutions this pass), so test live values.
+  if (a->get_x() + a->get_radius() < b->get_x() - b->get_radius() ||
+      a->get_x() - a->get_radius() > b->get_x() + b->get_radius() ||
+      a->get_y() + a->get_radius() < b->get_y() - b->get_radius() ||
+      a->get_y() - a->get_radius() > b->get_y() + b->get_radius()) {
+    return false; // skip if bounding boxes do not overlap
+  }
+  Vector2 center1 = {static_cast<float>(a->get_x()), static_cast<float>(a->get_y())};
+  Vector2 center2 = {static_cast<float>(b->get_x()), static_cast<float>(b->get_y())};
+  return CheckCollisionCircles(center1, static_cast<float>(a->get_radius()), center2, static_cast<float>(b->get_radius()));
 }
-void DetectCollison(){
+
+template <typename F>
+static int forEachCollisionCandidate(F &&f){
+  // Dynamic pairs from collisionGrid, then each dynamic body probed against staticGrid.
+  // Static bodies never move, so static-static pairs are never generated. Returns the pairs pruned by filters.
+  return collisionGrid.forEachCandidatePair(f) + collisionGrid.forEachPairWith(staticGrid, f);
+}
+
+void DetectCollison(int iterations, stepDiagnostics *diagnostics){
   // Reset per-frame flags then detect & resolve collisions between active players.
-  // Only valid (non-null) pointers are considered.
-  for (int i = 0; i < MAX_ENTITIES; ++i) {
+  // With `diagnostics`, penetration depth and contact count are accumulated in the same pass.
+  // Candidate pairs come from collisionGrid and staticGrid (built just before this pass), so only nearby
+  // pairs whose collision layers accept each other are tested.
+  // Touching pairs are reported to `contacts`, which emits begin/persist/end events at the end of the pass.
+  // `iterations` > 1 adds relaxation passes over the same candidates (stiffer piles, less penetration).
+  int end = entitySlotEnd();
+  for (int i = 0; i < end; ++i) {
     if (players[i]) players[i]->resetFlags();
   }
 
-  // Then check collisions between valid player pointers only.
-  for (int i = 0; i < MAX_ENTITIES; ++i) {
-    if (!players[i]) continue;
-    Vector2 center1 = {static_cast<float>(players[i]->get_x()), static_cast<float>(players[i]->get_y())};
-    for (int j = i + 1; j < MAX_ENTITIES; ++j) {
-      if (!players[j]) continue;
-      Vector2 center2 = {static_cast<float>(players[j]->get_x()), static_cast<float>(players[j]->get_y())};
-      if (players[i]->get_x() + players[i]->get_radius() < players[j]->get_x() - players[j]->get_radius() ||
-          players[i]->get_x() - players[i]->get_radius() > players[j]->get_x() + players[j]->get_radius() ||
-          players[i]->get_y() + players[i]->get_radius() < players[j]->get_y() - players[j]->get_radius() ||
-          players[i]->get_y() - players[i]->get_radius() > players[j]->get_y() + players[j]->get_radius()) {
-        continue; // skip if bounding boxes do not overlap
-      }
-      if (CheckCollisionCircles(center1, static_cast<float>(players[i]->get_radius()), center2, static_cast<float>(players[j]->get_radius()))) {
-        players[i]->setColliding(true);
-        players[j]->setColliding(true);
-        resolveCollision(players[i], players[j]);
-      }
+  contacts.beginStep();
+  double maxPenetration = 0.0, sumPenetration = 0.0;
+  int touching = 0;
+  int pruned = forEachCollisionCandidate([&](int i, int j) {
+    Entity *a = players[i];
+    Entity *b = players[j];
+    if (circlesTouch(a, b)) {
+      double nx, ny, penetration;
+      double impulse = resolveCollision(a, b, nx, ny, penetration);
+      contacts.report(handleOf(i), handleOf(j), static_cast<float>(nx), static_cast<float>(ny), static_cast<float>(impulse));
+      maxPenetration = std::max(maxPenetration, penetration);
+      sumPenetration += penetration;
+      ++touching;
     }
+  });
+  contacts.endStep();
+  // Later passes only correct what the earlier ones left; contacts and diagnostics describe the first.
+  for (int pass = 1; pass < iterations; ++pass) {
+    forEachCollisionCandidate([&](int i, int j) {
+      Entity *a = players[i];
+      Entity *b = players[j];
+      if (!circlesTouch(a, b)) return;
+      double nx, ny, penetration;
+      resolveCollision(a, b, nx, ny, penetration);
+    });
+  }
+  if (diagnostics) {
+    diagnostics->maxPenetration = maxPenetration;
+    diagnostics->meanPenetration = touching > 0 ? sumPenetration / touching : 0.0;
+    diagnostics->contactCount = touching;
+    diagnostics->pairsPruned = pruned;
   }
 }
-void updatePlayerProperties(){
+void updatePlayerProperties(double dt, stepDiagnostics *diagnostics){
   // Per-frame update:
-  // 1) reset collision flags/colors
-  // 2) apply input, physics and bounds per entity
-  // Entities flagged for deletion are cleaned up here.
-  // Reset colliding state and color each frame BEFORE processing input/physics
-  for (int i{0}; i < MAX_ENTITIES; i++){
-    if (!players[i]) {
-      continue;
-    }
+  // 1) queue this step's input as entity commands, resume the behaviours due this step (which queue
+  //    theirs), then apply every queued command (the only point in the step where entities are
+  //    spawned, deleted, resized or have velocities set from outside)
+  // 2) apply physics and bounds per entity
+  inputMgr.processInputs(dt);
+  behaviours.advance();
+  drainEntityCommands();
+  if (nbodyEnabled.load(std::memory_order_relaxed)) {
+    // Mutual attraction replaces uniform gravity; uses the tree built at the end of the previous step.
+    gravityParams params{nbodyTheta.load(std::memory_order_relaxed), static_cast<float>(NBODY_G),
+                         static_cast<float>(NBODY_SOFTENING)};
+    physics.setGravity(0.0);
+    physics.applyMutualGravity(worldTree, params, dt, diagnostics != nullptr);
+  } else {
+    physics.setGravity(GRAVITY);
   }
-  // Process inputs and physics once per frame (not per-entity)
-  inputMgr.processInputs();
-  physics.applyGravity();
+  physics.applyGravity(dt, diagnostics);
   windowInt.checkAllBounds();
+  windowInt.colorContacts(contacts); // last step's contacts, after bounds so boundary colors keep precedence
+}
 
-  for (int i{0}; i < MAX_ENTITIES; i++){
-    if (!players[i]) {
-      continue;
-    }
-    if (players[i]->isMarkedForDeletion()) {
-        physics.removeFromEntityList(players[i]);
-        inputMgr.removeFromEntityList(players[i]);
-        windowInt.removeFromEntityList(players[i]);
-        delete players[i];
-        players[i] = nullptr;
-        continue;
+// Frame-budget controller for the simulation step (simulation thread only).
+static frameBudget stepBudget("step", SIM_STEP_BUDGET_MS);
+static const int PHASE_INTEGRATE = stepBudget.addPhase("integrate");
+static const int PHASE_SPATIAL = stepBudget.addPhase("spatial build");
+static const int PHASE_SOLVER = stepBudget.addPhase("collision solver");
+static const int PHASE_COMMANDS = stepBudget.addPhase("command drain");
+static const int PHASE_HISTORY = stepBudget.addPhase("history record");
+static const int KNOB_SUBSTEPS = stepBudget.addKnob("max substep level", PHASE_INTEGRATE, MAX_SUBSTEP_LEVEL, 1, 1);
+static const int KNOB_SOLVER = stepBudget.addKnob("solver iterations", PHASE_SOLVER, SOLVER_ITERATIONS_MAX, 1, 1,
+                                                   SOLVER_ITERATIONS);
+static const int KNOB_SLEEP = stepBudget.addKnob("sleep speed", PHASE_INTEGRATE, 0.0, SLEEP_SPEED_MAX, 2.0);
+static const int KNOB_HISTORY = stepBudget.addKnob("history interval", PHASE_HISTORY, 1, HISTORY_RECORD_INTERVAL_MAX, 1);
+
+static std::vector<quadItem> samples; // reused each step by the spatial rebuild
+static collisionSamples collisionSplit; // samples split into dynamic / static bodies, reused likewise
+
+void stepSimulation(double dt){
+  // One simulation step; runs on the simulation thread (or the headless runner).
+  static long long stepCount = 0;
+  static uint64_t staticFingerprint = 0;
+  static int staticRebuilds = 0;
+  if (rewindActive.load(std::memory_order_relaxed)) {
+    // Paused on a recorded step: restore the one the main thread points at, and rebuild the tree
+    // so hover and selection work on the restored bodies. Queued commands wait for the resume.
+    // With a record interval above 1 the pool may be a few steps past the newest frame, so the
+    // current step is recorded first: begin() takes the newest frame to be what the pool holds.
+    if (!stepHistory.isRewinding() && stepHistory.frameCount() > 0 && stepHistory.cursorStep() != stepCount) {
+      stepHistory.record(stepCount);
     }
+    stepHistory.begin();
+    stepHistory.seek(rewindOffset.load(std::memory_order_relaxed));
+    gatherEntitySamples(samples);
+    worldTree.build(samples.data(), static_cast<int>(samples.size()));
+    inputMgr.processPointer(worldTree);
+    return;
+  }
+  if (stepHistory.isRewinding()) {
+    stepHistory.resume(); // later steps are discarded; simulation branches from the restored one
+    stepCount = stepHistory.cursorStep();
+    inputMgr.refreshControllable(); // restored bodies may have been revived or had canMove rewritten
+  }
+  using clock = std::chrono::steady_clock;
+  auto since = [](clock::time_point start) { return std::chrono::duration<double, std::milli>(clock::now() - start).count(); };
+  bool budget = budgetEnabled.load(std::memory_order_relaxed);
+  if (budget != stepBudget.isEnabled()) stepBudget.setEnabled(budget);
+  if (budget) {
+    // A disabled controller freezes its knobs, so the settings in effect stay as they are (and can be
+    // fixed by a headless caller, e.g. the history benchmark's sleep speed).
+    physics.setMaxSubstepLevel(static_cast<int>(stepBudget.value(KNOB_SUBSTEPS)));
+    physics.setSleepSpeed(stepBudget.value(KNOB_SLEEP));
+    solverIterations = static_cast<int>(stepBudget.value(KNOB_SOLVER));
+    historyInterval = static_cast<int>(stepBudget.value(KNOB_HISTORY));
+  }
+
+  stepDiagnostics diagnostics;
+  stepDiagnostics *measure = diagnosticsEnabled.load(std::memory_order_relaxed) ? &diagnostics : nullptr;
+  auto start = clock::now();
+  updatePlayerProperties(dt, measure);
+  stepBudget.record(PHASE_COMMANDS, commandStats.drainMs);
+  stepBudget.record(PHASE_INTEGRATE, since(start) - commandStats.drainMs);
+  // Rebuild spatial structures after deletions, so neither references a released slot.
+  start = clock::now();
+  gatherEntitySamples(samples);
+  worldTree.build(samples.data(), static_cast<int>(samples.size()));
+  splitCollisionSamples(samples, collisionSplit);
+  collisionGrid.build(collisionSplit.dynamicItems.data(), static_cast<int>(collisionSplit.dynamicItems.size()),
+                      collisionSplit.dynamicFilters.data());
+  if (staticRebuilds == 0 || collisionSplit.staticFingerprint != staticFingerprint) {
+    staticGrid.build(collisionSplit.staticItems.data(), static_cast<int>(collisionSplit.staticItems.size()),
+                     collisionSplit.staticFilters.data());
+    staticFingerprint = collisionSplit.staticFingerprint;
+    ++staticRebuilds;
+  }
+  inputMgr.processPointer(worldTree);
+  stepBudget.record(PHASE_SPATIAL, since(start));
+  start = clock::now();
+  DetectCollison(solverIterations, measure);
+  stepBudget.record(PHASE_SOLVER, since(start));
+  // History: a frame every `interval` steps; the deltas carry whatever changed in between.
+  ++stepCount;
+  start = clock::now();
+  if (historyEnabled.load(std::memory_order_relaxed)) {
+    if (stepCount % historyInterval == 0) stepHistory.record(stepCount);
+  } else if (stepHistory.frameCount() > 0) {
+    stepHistory.clear();
   }
+  stepBudget.record(PHASE_HISTORY, since(start));
+  stepBudget.update();
+  if (measure) {
+    diagnostics.staticBodies = staticGrid.itemCount();
+    diagnostics.staticRebuilds = staticRebuilds;
+    lastDiagnostics = diagnostics;
+  }
+}
+
+static int runHeadless(int steps, int entities){
+  // No window: fixed world size, fixed dt, diagnostics printed as CSV (one row per step) to stdout.
+  worldWidth = width;
+  worldHeight = height;
+  diagnosticsEnabled = true;
+  budgetEnabled = false; // fixed quality, so rows stay comparable
+  initializePlayers(entities);
+  const double dt = 1.0 / SIM_STEP_HZ;
+  std::printf("step,ms,bodies,kinetic,potential,total,momentum_x,momentum_y,max_penetration,mean_penetration,contacts,pairs_pruned\n");
+  for (int step = 1; step <= steps; ++step) {
+    auto start = std::chrono::steady_clock::now();
+    stepSimulation(dt);
+    exportEntityState(step);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    const stepDiagnostics &d = lastDiagnostics;
+    std::printf("%d,%.3f,%d,%.6g,%.6g,%.6g,%.6g,%.6g,%.4f,%.4f,%d,%d\n", step, ms, d.bodies, d.kineticEnergy,
+                d.potentialEnergy, d.totalEnergy(), d.momentumX, d.momentumY, d.maxPenetration,
+                d.meanPenetration, d.contactCount, d.pairsPruned);
+  }
+  return 0;
 }
 
-int main() {
-  // Initialize window, spawn entities and run simulation loop at fixed target FPS.
+static bool takeFlag(int &argc, char **argv, const char *flag){
+  // Remove `flag` from argv wherever it appears, so positional arguments keep their indices.
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], flag) != 0) continue;
+    for (int j = i; j + 1 < argc; ++j) argv[j] = argv[j + 1];
+    --argc;
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char **argv) {
+  // `--export` (demo or headless) publishes every step to shared memory for external readers (stateExport.h).
+  if (takeFlag(argc, argv, "--export") && !stateExport.open(STATE_EXPORT_NAME, STATE_EXPORT_CAPACITY)) {
+    std::fprintf(stderr, "state export: could not create shared memory region '%s'\n", STATE_EXPORT_NAME);
+  }
+#ifndef _WIN32
+  // `--listen` (demo or headless) feeds text commands from the Unix socket COMMAND_SOCKET_PATH into entityCommands.
+  commandFeeder feeder(entityCommands);
+  if (takeFlag(argc, argv, "--listen") && !feeder.start(COMMAND_SOCKET_PATH)) {
+    std::fprintf(stderr, "command feeder: could not listen on '%s'\n", COMMAND_SOCKET_PATH);
+  }
+#endif
+  // `--bench [name]` runs headless benchmarks instead of the demo.
+  if (argc > 1 && std::strcmp(argv[1], "--bench") == 0) {
+    return runBenchmarks(argc > 2 ? argv[2] : nullptr, stepSimulation);
+  }
+  // `--headless [steps] [entities]` steps the simulation without a window and prints diagnostics.
+  if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+    int steps = argc > 2 ? std::atoi(argv[2]) : 1000;
+    int entities = argc > 3 ? std::atoi(argv[3]) : INITIAL_ENTITIES;
+    return runHeadless(steps, entities);
+  }
+  // Initialize window and entities, then run the simulation on its own thread while this thread renders.
   InitWindow(width, height, "Basic Physics Simulation");
   SetWindowState(FLAG_WINDOW_RESIZABLE);
   
   SetExitKey(KEY_NULL); // disable default ESC exit to allow in-game key handling
-  //initializePlayers();
+  worldWidth = GetScreenWidth();
+  worldHeight = GetScreenHeight();
   initializePlayers(); // allocate players[] before dereferencing players[0]
-  players[0]->setCanMove(true);
+  inputMgr.setControllable(players[0], true);
   players[0]->set_color(GREEN);
   players[0]->setEntityBouncy(false);
-  SetTargetFPS(60);
+  players[0]->setCollisionLayer(LAYER_PLAYER);
+  players[0]->setCollisionMask(LAYER_ALL & ~LAYER_DEBRIS); // the player pushes through emitter debris
+  SetTargetFPS(TARGET_FPS);
+  // Render-side budget: the circle LOD radius in drawPlayers.
+  frameBudget drawBudget("draw", RENDER_FRAME_BUDGET_MS);
+  const int phaseDraw = drawBudget.addPhase("draw players");
+  const int knobLod = drawBudget.addKnob("LOD radius", phaseDraw, 0.0, DRAW_LOD_RADIUS_MAX, 4.0);
+
+  simulationThread simulation(stepSimulation);
+  simulation.start();
   while (!WindowShouldClose()) {
-    updatePlayerProperties();
-    DetectCollison();
-    BeginDrawing();
-    DrawFPS(width - 100, 10);
-    if (players[0]) {
-      players[0]->showInfo();
+    // Main thread: sample input and window size for the simulation, then draw the latest snapshot.
+    inputMgr.captureInputs();
+    worldWidth = GetScreenWidth();
+    worldHeight = GetScreenHeight();
+    const renderSnapshot &snapshot = simulation.latest();
+    // Rewind: R pauses on the newest recorded step (and resumes from the one shown); while paused,
+    // LEFT/RIGHT scrub one recorded frame per render frame (ten with SHIFT) and HOME/END jump to the
+    // oldest/newest. Nothing to rewind to while recording is off.
+    if (IsKeyPressed(KEY_R) && (rewindActive.load() || snapshot.historyFrames > 0)) {
+      rewindOffset = 0;
+      rewindActive = !rewindActive.load();
+    }
+    if (rewindActive.load()) {
+      int stride = IsKeyDown(KEY_LEFT_SHIFT) ? 10 : 1;
+      int offset = rewindOffset.load();
+      if (IsKeyDown(KEY_LEFT)) offset += stride;
+      if (IsKeyDown(KEY_RIGHT)) offset -= stride;
+      if (IsKeyPressed(KEY_HOME)) offset = snapshot.historyFrames - 1;
+      if (IsKeyPressed(KEY_END)) offset = 0;
+      rewindOffset = std::clamp(offset, 0, std::max(0, snapshot.historyFrames - 1));
     }
+
+    BeginDrawing();
     ClearBackground(RAYWHITE);
-    drawPlayers(); 
+    auto drawStart = std::chrono::steady_clock::now();
+    drawPlayers(snapshot, static_cast<float>(drawBudget.value(knobLod)));
+    drawBudget.record(phaseDraw, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - drawStart).count());
+    if (snapshot.hasHover) {
+      DrawCircleLines(static_cast<int>(snapshot.hoverCenter.x), static_cast<int>(snapshot.hoverCenter.y),
+                      snapshot.hoverRadius + 3.0f, DARKGRAY);
+    }
+    if (snapshot.hasSelection) {
+      DrawCircleLines(static_cast<int>(snapshot.selectionCenter.x), static_cast<int>(snapshot.selectionCenter.y),
+                      snapshot.selectionRadius + 5.0f, ORANGE);
+    }
+    if (snapshot.hasFocus) {
+      snapshot.focus.showInfo(); // the snapshot's copy, never the live entity
+    }
+    // Multi-rate stepping: how many bodies ran at each substep level (2^level substeps) last step.
+    std::string substeps = "Substeps:";
+    for (int level = 0; level <= MAX_SUBSTEP_LEVEL; ++level) {
+      substeps += " x" + std::to_string(1 << level) + "=" + std::to_string(snapshot.substepBodies[level]);
+    }
+    substeps += " asleep=" + std::to_string(snapshot.bodiesAsleep);
+    DrawText(substeps.c_str(), 10, 100, 10, BLACK);
+    DrawText(TextFormat("Budget%s: step %.2f/%.2f ms (substeps<=%d, solver x%d, sleep<%.0f px/s)  draw %.2f/%.2f ms (LOD r<%.0f)",
+                        budgetEnabled.load() ? "" : " (off)", snapshot.stepMs, SIM_STEP_BUDGET_MS, snapshot.maxSubstepLevel,
+                        snapshot.solverIterations, snapshot.sleepSpeed, drawBudget.smoothedMs(), RENDER_FRAME_BUDGET_MS,
+                        drawBudget.value(knobLod)),
+             10, 160, 10, BLACK);
+    const commandQueueStats &queued = snapshot.commands;
+    DrawText(TextFormat("Commands: depth %d (max %d)  applied %d in %.3f ms  total %llu  dropped %llu", queued.depth,
+                        queued.maxDepth, queued.applied, queued.drainMs, static_cast<unsigned long long>(queued.total),
+                        static_cast<unsigned long long>(queued.dropped)),
+             10, 175, 10, BLACK);
+    DrawText(TextFormat("Behaviours: %d active, %d resumed in %.3f ms  [E emitter, T despawn, P patrol]",
+                        snapshot.behavioursActive, snapshot.behavioursResumed, snapshot.behaviourMs),
+             10, 190, 10, BLACK);
+    if (snapshot.rewinding) {
+      DrawText(TextFormat("REWIND step %lld (-%d of %d recorded, restored in %.2f ms)  R resume  LEFT/RIGHT scrub (SHIFT x10)  HOME/END",
+                          snapshot.historyStep, snapshot.rewindOffset, snapshot.historyFrames, snapshot.seekMs),
+               10, 205, 20, RED);
+    } else {
+      DrawText(TextFormat("History%s: %d frames, one per %d step(s) (%.1f s), %.1f of %d MB  [R rewind, H record]",
+                          historyEnabled.load() ? "" : " (off)", snapshot.historyFrames, snapshot.historyInterval,
+                          snapshot.historySteps / static_cast<double>(SIM_STEP_HZ), snapshot.historyMB, HISTORY_MEMORY_MB),
+               10, 205, 10, BLACK);
+    }
+    if (snapshot.hasDiagnostics) {
+      const stepDiagnostics &d = snapshot.diagnostics;
+      DrawText(TextFormat("Energy: kinetic %.4g  potential %.4g  total %.4g", d.kineticEnergy, d.potentialEnergy, d.totalEnergy()),
+               10, 115, 10, BLACK);
+      DrawText(TextFormat("Momentum: (%.4g, %.4g)", d.momentumX, d.momentumY), 10, 130, 10, BLACK);
+      DrawText(TextFormat("Contacts: %d  penetration max %.3f  mean %.3f  pruned by layers %d  static %d (rebuilt %d)  [K pin]",
+                          d.contactCount, d.maxPenetration, d.meanPenetration, d.pairsPruned, d.staticBodies, d.staticRebuilds),
+               10, 145, 10, BLACK);
+    }
+    DrawFPS(width - 100, 10);
     EndDrawing();
+    drawBudget.setEnabled(budgetEnabled.load());
+    drawBudget.update();
   }
+  simulation.stop();
   CloseWindow();
   return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,104 @@
+// parallel implementation: fixed pool of std::threads woken per parallelFor call; chunks are claimed atomically.
+
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class workerPool {
+    private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(int, int, int)> *body{nullptr};
+    int count{0};
+    int grain{1};
+    long long generation{0};
+    int active{0};          // pool threads still working on the current generation
+    bool stopping{false};
+    std::atomic<int> nextChunk{0};
+
+    void runChunks(int worker){
+        int chunks = (count + grain - 1) / grain;
+        for (int chunk = nextChunk.fetch_add(1); chunk < chunks; chunk = nextChunk.fetch_add(1)) {
+            int begin = chunk * grain;
+            (*body)(begin, std::min(count, begin + grain), worker);
+        }
+    }
+
+    void loop(int worker){
+        long long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            runChunks(worker);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0) done.notify_one();
+        }
+    }
+
+    public:
+    workerPool(){
+        int n = static_cast<int>(std::thread::hardware_concurrency());
+        n = std::max(0, n - 2); // leave one core for the caller and one for the render thread
+        for (int i = 0; i < n; ++i) threads.emplace_back(&workerPool::loop, this, i + 1);
+    }
+    ~workerPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : threads) t.join();
+    }
+    int workers() const {
+        return static_cast<int>(threads.size()) + 1;
+    }
+    void run(int n, int g, const std::function<void(int, int, int)> &fn){
+        if (n <= 0) return;
+        g = std::max(1, g);
+        if (threads.empty() || n <= g) {
+            fn(0, n, 0); // not worth waking anyone
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            body = &fn;
+            count = n;
+            grain = g;
+            nextChunk.store(0);
+            active = static_cast<int>(threads.size());
+            ++generation;
+        }
+        wake.notify_all();
+        runChunks(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return active == 0; });
+        body = nullptr;
+    }
+};
+
+workerPool &pool(){
+    static workerPool instance;
+    return instance;
+}
+
+} // namespace
+
+int parallelWorkerCount(){
+    return pool().workers();
+}
+
+void parallelFor(int count, int grain, const std::function<void(int begin, int end, int worker)> &body){
+    pool().run(count, grain, body);
+}
@@ -0,0 +1,17 @@
+// parallel: small persistent worker pool for data-parallel loops inside the simulation step.
+/**
+ * @brief parallelFor splits [0, count) into chunks of `grain` and runs them on the pool plus the caller.
+ * - Blocks until every chunk is done, so it can be dropped into an existing serial pass.
+ * - The callback receives (begin, end, worker); worker is in [0, parallelWorkerCount()) and is stable
+ *   for the duration of the call, so it can index per-worker scratch or partial sums.
+ * - Calls must not nest and must come from one thread at a time (the simulation thread).
+ */
+#ifndef parallel_h
+#define parallel_h
+#include <functional>
+
+/** Number of distinct `worker` ids a parallelFor callback can see (pool threads + caller). */
+int parallelWorkerCount();
+
+void parallelFor(int count, int grain, const std::function<void(int begin, int end, int worker)> &body);
+#endif // parallel_h
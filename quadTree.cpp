@@ -0,0 +1,254 @@
+// quadTree implementation: in-place quadrant partitioning build, mass aggregation, Barnes–Hut traversal
+// and the radius / box / ray / point queries.
+
+#include "quadTree.h"
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+
+void quadTree::build(const quadItem *source, int count){
+    items.assign(source, source + count);
+    nodes.clear();
+    if (count == 0) return;
+
+    float minX = items[0].x, maxX = items[0].x;
+    float minY = items[0].y, maxY = items[0].y;
+    for (const quadItem &item : items) {
+        minX = std::min(minX, item.x); maxX = std::max(maxX, item.x);
+        minY = std::min(minY, item.y); maxY = std::max(maxY, item.y);
+    }
+    // Square root cell, padded slightly so items on the max edge still fall inside.
+    float size = std::max(maxX - minX, maxY - minY) * 1.001f + 1.0f;
+    nodes.reserve(static_cast<size_t>(count / QUADTREE_LEAF_SIZE) * 2 + 16);
+    nodes.emplace_back();
+    buildNode(0, 0, count, minX, minY, size, 0);
+}
+
+void quadTree::buildNode(int index, int first, int count, float minX, float minY, float size, int depth){
+    // Note: `nodes` may reallocate while children are built, so only indices are held across calls.
+    nodes[index] = quadNode{minX, minY, size, 0.0f, 0.0f, 0.0f, 0.0f, -1, first, count};
+    if (count <= QUADTREE_LEAF_SIZE || depth >= QUADTREE_MAX_DEPTH) {
+        double mass = 0.0, mx = 0.0, my = 0.0;
+        float maxRadius = 0.0f;
+        for (int i = first; i < first + count; ++i) {
+            const quadItem &item = items[i];
+            mass += item.mass;
+            mx += static_cast<double>(item.mass) * item.x;
+            my += static_cast<double>(item.mass) * item.y;
+            maxRadius = std::max(maxRadius, item.radius);
+        }
+        quadNode &node = nodes[index];
+        node.mass = static_cast<float>(mass);
+        node.comX = mass > 0.0 ? static_cast<float>(mx / mass) : minX + size * 0.5f;
+        node.comY = mass > 0.0 ? static_cast<float>(my / mass) : minY + size * 0.5f;
+        node.maxRadius = maxRadius;
+        return;
+    }
+
+    // Partition the range into quadrants: split by y, then each half by x.
+    float half = size * 0.5f;
+    float midX = minX + half, midY = minY + half;
+    quadItem *begin = items.data() + first;
+    quadItem *end = begin + count;
+    quadItem *splitY = std::partition(begin, end, [midY](const quadItem &item) { return item.y < midY; });
+    quadItem *splitLow = std::partition(begin, splitY, [midX](const quadItem &item) { return item.x < midX; });
+    quadItem *splitHigh = std::partition(splitY, end, [midX](const quadItem &item) { return item.x < midX; });
+    int bounds[5] = {first,
+                     first + static_cast<int>(splitLow - begin),
+                     first + static_cast<int>(splitY - begin),
+                     first + static_cast<int>(splitHigh - begin),
+                     first + count};
+
+    int childBase = static_cast<int>(nodes.size());
+    nodes.resize(nodes.size() + 4);
+    nodes[index].firstChild = childBase;
+    for (int c = 0; c < 4; ++c) {
+        float childX = (c & 1) ? midX : minX;
+        float childY = (c & 2) ? midY : minY;
+        buildNode(childBase + c, bounds[c], bounds[c + 1] - bounds[c], childX, childY, half, depth + 1);
+    }
+
+    double mass = 0.0, mx = 0.0, my = 0.0;
+    float maxRadius = 0.0f;
+    for (int c = 0; c < 4; ++c) {
+        const quadNode &child = nodes[childBase + c];
+        mass += child.mass;
+        mx += static_cast<double>(child.mass) * child.comX;
+        my += static_cast<double>(child.mass) * child.comY;
+        maxRadius = std::max(maxRadius, child.maxRadius);
+    }
+    quadNode &node = nodes[index];
+    node.mass = static_cast<float>(mass);
+    node.comX = mass > 0.0 ? static_cast<float>(mx / mass) : midX;
+    node.comY = mass > 0.0 ? static_cast<float>(my / mass) : midY;
+    node.maxRadius = maxRadius;
+}
+
+bool quadTree::empty() const {
+    return items.empty();
+}
+
+const std::vector<quadNode> &quadTree::getNodes() const {
+    return nodes;
+}
+
+const std::vector<quadItem> &quadTree::getItems() const {
+    return items;
+}
+
+void quadTree::gravityAt(float x, float y, int selfSlot, const gravityParams &params, double &ax, double &ay,
+                         double *potential) const {
+    ax = 0.0;
+    ay = 0.0;
+    double phi = 0.0;
+    if (potential) *potential = 0.0;
+    if (nodes.empty()) return;
+    const float theta2 = params.theta * params.theta;
+    int stack[128];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const quadNode &node = nodes[stack[--top]];
+        if (node.count == 0) continue;
+        float dx = node.comX - x;
+        float dy = node.comY - y;
+        float d2 = dx * dx + dy * dy;
+        bool inside = x >= node.minX && x < node.minX + node.size && y >= node.minY && y < node.minY + node.size;
+        if (node.firstChild >= 0 && !inside && node.size * node.size < theta2 * d2) {
+            // Far enough: treat the whole cell as one body at its center of mass.
+            float r2 = d2 + params.softening;
+            float r = std::sqrt(r2);
+            float inv = params.G * node.mass / (r2 * r);
+            ax += inv * dx;
+            ay += inv * dy;
+            if (potential) phi -= params.G * node.mass / r;
+            continue;
+        }
+        if (node.firstChild < 0 || top + 4 > 128) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const quadItem &item = items[i];
+                if (item.slot == selfSlot) continue;
+                float ix = item.x - x;
+                float iy = item.y - y;
+                float r2 = ix * ix + iy * iy + params.softening;
+                float r = std::sqrt(r2);
+                float inv = params.G * item.mass / (r2 * r);
+                ax += inv * ix;
+                ay += inv * iy;
+                if (potential) phi -= params.G * item.mass / r;
+            }
+            continue;
+        }
+        for (int c = 0; c < 4; ++c) stack[top++] = node.firstChild + c;
+    }
+    if (potential) *potential = phi;
+}
+
+int quadTree::queryRadius(float x, float y, float r, int *out, int capacity) const {
+    int found = 0;
+    forEachInBox(x - r, y - r, x + r, y + r, [&](int i) {
+        const quadItem &item = items[i];
+        float dx = item.x - x, dy = item.y - y, reach = item.radius + r;
+        if (dx * dx + dy * dy > reach * reach) return;
+        if (found < capacity) out[found] = item.slot;
+        ++found;
+    });
+    return found;
+}
+
+int quadTree::queryBox(float minX, float minY, float maxX, float maxY, int *out, int capacity) const {
+    int found = 0;
+    forEachInBox(minX, minY, maxX, maxY, [&](int i) {
+        const quadItem &item = items[i];
+        // Exact circle-vs-box: distance from the center to the closest point of the box.
+        float cx = std::clamp(item.x, minX, maxX) - item.x;
+        float cy = std::clamp(item.y, minY, maxY) - item.y;
+        if (cx * cx + cy * cy > item.radius * item.radius) return;
+        if (found < capacity) out[found] = item.slot;
+        ++found;
+    });
+    return found;
+}
+
+int quadTree::raycast(float ox, float oy, float dx, float dy, float maxDistance, float *hitDistance) const {
+    if (nodes.empty()) return -1;
+    float length = std::sqrt(dx * dx + dy * dy);
+    if (length <= 0.0f) return -1;
+    dx /= length;
+    dy /= length;
+    // Reciprocals for the slab test; an axis-parallel ray gets a huge value instead of inf*0 NaNs.
+    float invX = std::abs(dx) > 1e-12f ? 1.0f / dx : 1e30f;
+    float invY = std::abs(dy) > 1e-12f ? 1.0f / dy : 1e30f;
+    auto enterDistance = [&](const quadNode &node) {
+        float pad = node.maxRadius;
+        float tx1 = (node.minX - pad - ox) * invX, tx2 = (node.minX + node.size + pad - ox) * invX;
+        float ty1 = (node.minY - pad - oy) * invY, ty2 = (node.minY + node.size + pad - oy) * invY;
+        float tNear = std::max(std::min(tx1, tx2), std::min(ty1, ty2));
+        float tFar = std::min(std::max(tx1, tx2), std::max(ty1, ty2));
+        if (tFar < 0.0f || tNear > tFar) return 1e30f;
+        return std::max(tNear, 0.0f);
+    };
+
+    float best = maxDistance;
+    int bestSlot = -1;
+    struct pending { int node; float t; };
+    pending stack[128];
+    int top = 0;
+    float rootT = enterDistance(nodes[0]);
+    if (rootT <= best) stack[top++] = pending{0, rootT};
+    while (top > 0) {
+        pending current = stack[--top];
+        if (current.t > best) continue; // a nearer hit was found after this node was queued
+        const quadNode &node = nodes[current.node];
+        if (node.firstChild < 0 || top + 4 > 128) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const quadItem &item = items[i];
+                float mx = ox - item.x, my = oy - item.y;
+                float b = mx * dx + my * dy;
+                float c = mx * mx + my * my - item.radius * item.radius;
+                if (c > 0.0f && b > 0.0f) continue; // outside and pointing away
+                float disc = b * b - c;
+                if (disc < 0.0f) continue;
+                float t = std::max(0.0f, -b - std::sqrt(disc));
+                if (t <= best) {
+                    best = t;
+                    bestSlot = item.slot;
+                }
+            }
+            continue;
+        }
+        // Push children far-to-near so the nearest is visited first and tightens `best` early.
+        pending children[4];
+        int n = 0;
+        for (int c = 0; c < 4; ++c) {
+            const quadNode &child = nodes[node.firstChild + c];
+            if (child.count == 0) continue;
+            float t = enterDistance(child);
+            if (t <= best) {
+                // Insertion sort by descending t: at most four entries, and no -Warray-bounds from std::sort.
+                int at = n++;
+                for (; at > 0 && children[at - 1].t < t; --at) children[at] = children[at - 1];
+                children[at] = pending{node.firstChild + c, t};
+            }
+        }
+        for (int c = 0; c < n; ++c) stack[top++] = children[c];
+    }
+    if (bestSlot >= 0 && hitDistance) *hitDistance = best;
+    return bestSlot;
+}
+
+int quadTree::pick(float x, float y) const {
+    int bestSlot = -1;
+    float bestD2 = 0.0f;
+    forEachInBox(x, y, x, y, [&](int i) {
+        const quadItem &item = items[i];
+        float dx = item.x - x, dy = item.y - y;
+        float d2 = dx * dx + dy * dy;
+        if (d2 > item.radius * item.radius) return;
+        if (bestSlot < 0 || d2 < bestD2) {
+            bestSlot = item.slot;
+            bestD2 = d2;
+        }
+    });
+    return bestSlot;
+}
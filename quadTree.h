@@ -0,0 +1,140 @@
+// quadTree: flat, per-step rebuilt quadtree over entity centers.
+/**
+ * @brief One node array serves Barnes–Hut gravity, spatial queries and (as an alternative to
+ * hierarchicalGrid) candidate-pair enumeration.
+ * - Every node stores its square bounds, total mass, center of mass and the largest radius below it,
+ *   so gravity can approximate far cells and overlap queries can expand by the real radius.
+ * - Items are partitioned in place while building, so each node owns a contiguous item range
+ *   [first, first + count) and leaves hold at most QUADTREE_LEAF_SIZE items.
+ * - The tree is non-owning: items carry the players[] slot they were built from.
+ */
+#ifndef quadTree_h
+#define quadTree_h
+#include <vector>
+
+/** Entity sample captured at build time. */
+struct quadItem {
+    float x;
+    float y;
+    float radius;
+    float mass;
+    int slot; ///< index into players[]
+};
+
+struct quadNode {
+    float minX;
+    float minY;
+    float size;        ///< edge length of the square cell
+    float comX;        ///< center of mass
+    float comY;
+    float mass;        ///< total mass below this node
+    float maxRadius;   ///< largest item radius below this node
+    int firstChild;    ///< index of the first of four consecutive children, -1 for a leaf
+    int first;         ///< item range covered by this subtree
+    int count;
+};
+
+/** Barnes–Hut tuning: theta is the opening angle (cell size / distance) below which a cell is approximated. */
+struct gravityParams {
+    float theta;
+    float G;
+    float softening; ///< added to squared distance to avoid singular close encounters
+};
+
+class quadTree {
+    private:
+    std::vector<quadNode> nodes;
+    std::vector<quadItem> items;
+    void buildNode(int index, int first, int count, float minX, float minY, float size, int depth);
+    public:
+    quadTree() = default;
+
+    /** Rebuild from scratch over `count` items (copied and reordered internally). */
+    void build(const quadItem *source, int count);
+
+    bool empty() const;
+    const std::vector<quadNode> &getNodes() const;
+    const std::vector<quadItem> &getItems() const;
+
+    /**
+     * @brief Gravitational acceleration at (x, y) from every item except `selfSlot`.
+     * Cells whose size / distance is below params.theta are replaced by their center of mass.
+     * With `potential`, the softened potential -sum(G * m / sqrt(r^2 + softening)) at (x, y) is
+     * accumulated from the same cells and written there too.
+     */
+    void gravityAt(float x, float y, int selfSlot, const gravityParams &params, double &ax, double &ay,
+                   double *potential = nullptr) const;
+
+    // Spatial queries. Results are players[] slots as of the last build, written into a caller-owned
+    // buffer so queries never allocate. The return value is the total number of matches, which may
+    // exceed `capacity`; only the first `capacity` are written.
+
+    /** Entities whose circle overlaps the circle of radius `r` around (x, y). */
+    int queryRadius(float x, float y, float r, int *out, int capacity) const;
+
+    /** Entities whose circle overlaps the box [minX,maxX] x [minY,maxY]. */
+    int queryBox(float minX, float minY, float maxX, float maxY, int *out, int capacity) const;
+
+    /**
+     * @brief First entity hit by the ray from (ox, oy) along (dx, dy) within `maxDistance` pixels.
+     * @param hitDistance optional; receives the distance to the hit (0 when the origin starts inside)
+     * @return slot, or -1 when nothing is hit
+     */
+    int raycast(float ox, float oy, float dx, float dy, float maxDistance, float *hitDistance) const;
+
+    /** Entity under the point (x, y); with overlaps, the one whose center is nearest. -1 when none. */
+    int pick(float x, float y) const;
+
+    /**
+     * @brief Call f(slotA, slotB) once for each pair of items whose bounding boxes overlap.
+     * Candidate pairs only; the caller does the exact circle test.
+     */
+    template <typename F>
+    void forEachCandidatePair(F &&f) const;
+
+    /** Call f(itemIndex) for every item whose circle's bounding box overlaps [minX,maxX] x [minY,maxY]. */
+    template <typename F>
+    void forEachInBox(float minX, float minY, float maxX, float maxY, F &&f) const;
+};
+
+template <typename F>
+void quadTree::forEachInBox(float minX, float minY, float maxX, float maxY, F &&f) const {
+    if (nodes.empty()) return;
+    int stack[128];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const quadNode &node = nodes[stack[--top]];
+        // Expand the cell by the largest radius it contains so circles straddling the edge are not missed.
+        float pad = node.maxRadius;
+        if (node.minX - pad > maxX || node.minX + node.size + pad < minX ||
+            node.minY - pad > maxY || node.minY + node.size + pad < minY) {
+            continue;
+        }
+        if (node.firstChild < 0 || top + 4 > 128) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const quadItem &item = items[i];
+                if (item.x + item.radius < minX || item.x - item.radius > maxX ||
+                    item.y + item.radius < minY || item.y - item.radius > maxY) {
+                    continue;
+                }
+                f(i);
+            }
+            continue;
+        }
+        for (int c = 0; c < 4; ++c) {
+            if (nodes[node.firstChild + c].count > 0) stack[top++] = node.firstChild + c;
+        }
+    }
+}
+
+template <typename F>
+void quadTree::forEachCandidatePair(F &&f) const {
+    for (int i = 0; i < static_cast<int>(items.size()); ++i) {
+        const quadItem &a = items[i];
+        forEachInBox(a.x - a.radius, a.y - a.radius, a.x + a.radius, a.y + a.radius, [&](int j) {
+            if (j > i) f(a.slot, items[j].slot); // report each unordered pair once
+        });
+    }
+}
+#endif // quadTree_h
@@ -0,0 +1,328 @@
+// rewindHistory implementation: keyframe/delta recording against a mirror, replay, and budgeted eviction.
+
+#include "rewindHistory.h"
+#include "config.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+static uint8_t flagsOf(const Entity &entity){
+    return (entity.getEntityStatic() ? HISTORY_STATIC : 0) | (entity.getEntityBouncy() ? HISTORY_BOUNCY : 0) |
+           (entity.getCanMove() ? HISTORY_CAN_MOVE : 0) | (entity.getOnGround() ? HISTORY_ON_GROUND : 0) |
+           (entity.getAtCeiling() ? HISTORY_AT_CEILING : 0) | (entity.getAtLeft() ? HISTORY_AT_LEFT : 0) |
+           (entity.getAtRight() ? HISTORY_AT_RIGHT : 0);
+}
+
+static historyRecord capture(int slot, const Entity &entity){
+    historyRecord record;
+    record.slot = slot;
+    record.x = static_cast<float>(entity.get_x());
+    record.y = static_cast<float>(entity.get_y());
+    record.vx = static_cast<float>(entity.get_vx());
+    record.vy = static_cast<float>(entity.get_vy());
+    record.radius = static_cast<float>(entity.get_radius());
+    record.weight = static_cast<float>(entity.getWeight());
+    record.layer = entity.getCollisionLayer();
+    record.mask = entity.getCollisionMask();
+    record.color = entity.get_color();
+    record.flags = flagsOf(entity);
+    return record;
+}
+
+static bool changedSince(const historyRecord &known, const Entity &entity){
+    // Motion within the tolerances is left out; everything else must match exactly.
+    const Color color = entity.get_color();
+    return std::abs(entity.get_x() - known.x) > HISTORY_POSITION_EPSILON ||
+           std::abs(entity.get_y() - known.y) > HISTORY_POSITION_EPSILON ||
+           std::abs(entity.get_vx() - known.vx) > HISTORY_VELOCITY_EPSILON ||
+           std::abs(entity.get_vy() - known.vy) > HISTORY_VELOCITY_EPSILON ||
+           static_cast<float>(entity.get_radius()) != known.radius ||
+           static_cast<float>(entity.getWeight()) != known.weight ||
+           entity.getCollisionLayer() != known.layer || entity.getCollisionMask() != known.mask || color.r != known.color.r ||
+           color.g != known.color.g || color.b != known.color.b || color.a != known.color.a ||
+           flagsOf(entity) != known.flags;
+}
+
+static void restore(Entity &entity, const historyRecord &record){
+    entity.set_x(record.x);
+    entity.set_y(record.y);
+    entity.setVelocity(record.vx, record.vy);
+    entity.set_radius(record.radius);
+    entity.setWeight(record.weight);
+    entity.set_color(record.color);
+    entity.setCollisionLayer(record.layer);
+    entity.setCollisionMask(record.mask);
+    entity.setStatic(record.flags & HISTORY_STATIC);
+    entity.setEntityBouncy(record.flags & HISTORY_BOUNCY);
+    entity.setCanMove(record.flags & HISTORY_CAN_MOVE);
+    entity.setOnGround(record.flags & HISTORY_ON_GROUND);
+    entity.setAtCeiling(record.flags & HISTORY_AT_CEILING);
+    entity.setAtLeft(record.flags & HISTORY_AT_LEFT);
+    entity.setAtRight(record.flags & HISTORY_AT_RIGHT);
+}
+
+rewindHistory::rewindHistory(historyPool pool, size_t memoryBytes, int keyframeInterval, int slotCapacity)
+    : pool(std::move(pool)), budgetBytes(memoryBytes), keyframeInterval(std::max(1, keyframeInterval)),
+      changed(static_cast<size_t>(std::max(0, slotCapacity)), 0) {}
+
+void rewindHistory::markChanged(int slot){
+    if (slot >= 0 && static_cast<size_t>(slot) < changed.size()) changed[slot] = 1;
+}
+
+size_t rewindHistory::bytesOf(const historyFrame &frame){
+    return sizeof(historyFrame) + frame.records.capacity() * sizeof(historyRecord) +
+           frame.removed.capacity() * sizeof(int32_t);
+}
+
+void rewindHistory::ensureSlots(size_t count){
+    if (mirror.size() >= count) return;
+    mirror.resize(count);
+    mirrorLive.resize(count, 0);
+}
+
+void rewindHistory::record(long long step){
+    if (rewinding) return;
+    auto start = std::chrono::steady_clock::now();
+    const std::vector<Entity*> &slots = *pool.slots;
+    const int end = pool.slotEnd();
+    ensureSlots(static_cast<size_t>(end));
+    historyFrame frame;
+    frame.step = step;
+    // A new keyframe is also due once the deltas since the last one outweigh it (busy scenes), which
+    // keeps restores to at most about two keyframes' worth of replay and groups small enough to evict.
+    frame.keyframe = frames.empty() || sinceKeyframe >= keyframeInterval || deltaBytes >= keyframeBytes;
+    // Chunks touch disjoint slots of the mirror; each worker collects into its own scratch.
+    const int workers = parallelWorkerCount();
+    if (static_cast<int>(scratch.size()) < workers) scratch.resize(workers);
+    for (recordScratch &own : scratch) {
+        own.records.clear();
+        own.removed.clear();
+        own.reported = 0;
+        own.unreportedChange = -1;
+    }
+    const bool keyframe = frame.keyframe;
+    parallelFor(end, 4096, [&](int begin, int stop, int worker) {
+        recordScratch &own = scratch[worker];
+        for (int slot = begin; slot < stop; ++slot) {
+            const bool reported = static_cast<size_t>(slot) >= changed.size() || changed[slot];
+            if (!keyframe && !reported) {
+#if HISTORY_VERIFY_MARKS
+                const Entity *entity = slots[slot];
+                const bool live = entity != nullptr;
+                if (live != (mirrorLive[slot] != 0) || (live && changedSince(mirror[slot], *entity))) {
+                    own.unreportedChange = slot;
+                }
+#endif
+                continue;
+            }
+            if (static_cast<size_t>(slot) < changed.size()) changed[slot] = 0;
+            ++own.reported;
+            const Entity *entity = slots[slot];
+            if (!entity) {
+                if (mirrorLive[slot] && !keyframe) own.removed.push_back(slot);
+                mirrorLive[slot] = 0;
+                continue;
+            }
+            historyRecord &known = mirror[slot];
+            if (!keyframe && mirrorLive[slot] && !changedSince(known, *entity)) continue;
+            known = capture(slot, *entity);
+            mirrorLive[slot] = 1;
+            own.records.push_back(known);
+        }
+    });
+    // Exact-size storage, so the budget counts what is held. Order within a frame does not matter.
+    size_t recordCount = 0, removedCount = 0;
+    lastReported = 0;
+    for (const recordScratch &own : scratch) {
+        recordCount += own.records.size();
+        removedCount += own.removed.size();
+        lastReported += own.reported;
+        if (own.unreportedChange >= 0) {
+            TraceLog(LOG_ERROR, "HISTORY: slot %d changed before step %lld without markChanged()", own.unreportedChange, step);
+            std::abort();
+        }
+    }
+    frame.records.reserve(recordCount);
+    frame.removed.reserve(removedCount);
+    for (const recordScratch &own : scratch) {
+        frame.records.insert(frame.records.end(), own.records.begin(), own.records.end());
+        frame.removed.insert(frame.removed.end(), own.removed.begin(), own.removed.end());
+    }
+    const size_t bytes = bytesOf(frame);
+    if (frame.keyframe) {
+        sinceKeyframe = 1;
+        keyframeBytes = bytes;
+        deltaBytes = 0;
+    } else {
+        ++sinceKeyframe;
+        deltaBytes += bytes;
+    }
+    if (frame.keyframe) ++keyframes;
+    frameBytes += bytes;
+    frames.push_back(std::move(frame));
+    evict();
+    lastRecordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void rewindHistory::clear(){
+    if (rewinding) return;
+    frames.clear();
+    frameBytes = keyframeBytes = deltaBytes = 0;
+    keyframes = sinceKeyframe = 0;
+}
+
+void rewindHistory::evict(){
+    // Drop whole keyframe groups from the front; the newest group stays even if it alone is over budget.
+    while (frameBytes > budgetBytes) {
+        size_t next = 1;
+        while (next < frames.size() && !frames[next].keyframe) ++next;
+        if (next >= frames.size()) break;
+        for (size_t i = 0; i < next; ++i) {
+            if (frames.front().keyframe) --keyframes;
+            frameBytes -= bytesOf(frames.front());
+            frames.pop_front();
+        }
+    }
+}
+
+void rewindHistory::begin(){
+    if (rewinding) return;
+    rewinding = true;
+    // The pool is at the newest frame, which is exactly what the mirror reconstructs.
+    working = mirror;
+    workingLive = mirrorLive;
+    dirtyMark.assign(working.size(), 0);
+    dirty.clear();
+    cursor = static_cast<int>(frames.size()) - 1;
+}
+
+void rewindHistory::markDirty(int slot){
+    if (dirtyMark[slot]) return;
+    dirtyMark[slot] = 1;
+    dirty.push_back(slot);
+}
+
+void rewindHistory::applyFrame(const historyFrame &frame){
+    if (frame.keyframe) {
+        for (size_t slot = 0; slot < workingLive.size(); ++slot) {
+            if (!workingLive[slot]) continue;
+            workingLive[slot] = 0;
+            markDirty(static_cast<int>(slot));
+        }
+    }
+    for (int32_t slot : frame.removed) {
+        workingLive[slot] = 0;
+        markDirty(slot);
+    }
+    for (const historyRecord &record : frame.records) {
+        working[record.slot] = record;
+        workingLive[record.slot] = 1;
+        markDirty(record.slot);
+    }
+}
+
+void rewindHistory::writeDirtyToPool(){
+    // Only slots touched by the replayed frames are written, so scrubbing a settled scene is cheap.
+    std::vector<Entity*> &slots = *pool.slots;
+    std::vector<int> revive;
+    for (int slot : dirty) {
+        if (!workingLive[slot] && slots[slot]) pool.release(slot);
+        if (workingLive[slot] && !slots[slot]) revive.push_back(slot);
+    }
+    if (!revive.empty()) pool.occupy(revive);
+    for (int slot : dirty) {
+        dirtyMark[slot] = 0;
+        if (workingLive[slot] && slots[slot]) restore(*slots[slot], working[slot]);
+    }
+    dirty.clear();
+}
+
+int rewindHistory::seek(int offset){
+    if (!rewinding || frames.empty()) return 0;
+    auto start = std::chrono::steady_clock::now();
+    const int newest = static_cast<int>(frames.size()) - 1;
+    const int target = newest - std::clamp(offset, 0, newest);
+    if (target != cursor) {
+        int key = target;
+        while (!frames[key].keyframe) --key; // frames[0] is always a keyframe
+        // Forward within the same keyframe group: replay only the frames in between.
+        if (cursor < key || cursor > target) {
+            applyFrame(frames[key]);
+            cursor = key;
+        }
+        while (cursor < target) applyFrame(frames[++cursor]);
+        writeDirtyToPool();
+    }
+    lastSeekMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return newest - cursor;
+}
+
+void rewindHistory::resume(){
+    if (!rewinding) return;
+    rewinding = false;
+    if (cursor < 0) return;
+    while (static_cast<int>(frames.size()) > cursor + 1) {
+        if (frames.back().keyframe) --keyframes;
+        frameBytes -= bytesOf(frames.back());
+        frames.pop_back();
+    }
+    int key = cursor;
+    while (!frames[key].keyframe) --key;
+    sinceKeyframe = cursor - key + 1;
+    keyframeBytes = bytesOf(frames[key]);
+    deltaBytes = 0;
+    for (int i = key + 1; i <= cursor; ++i) deltaBytes += bytesOf(frames[i]);
+    // The pool now holds the cursor frame; the next delta is taken against it.
+    mirror = working;
+    mirrorLive = workingLive;
+    cursor = -1;
+}
+
+bool rewindHistory::isRewinding() const {
+    return rewinding;
+}
+
+int rewindHistory::frameCount() const {
+    return static_cast<int>(frames.size());
+}
+
+int rewindHistory::keyframeCount() const {
+    return keyframes;
+}
+
+int rewindHistory::cursorOffset() const {
+    return rewinding && cursor >= 0 ? static_cast<int>(frames.size()) - 1 - cursor : 0;
+}
+
+long long rewindHistory::cursorStep() const {
+    if (frames.empty()) return 0;
+    return rewinding && cursor >= 0 ? frames[cursor].step : frames.back().step;
+}
+
+long long rewindHistory::stepSpan() const {
+    return frames.empty() ? 0 : frames.back().step - frames.front().step;
+}
+
+size_t rewindHistory::memoryBytes() const {
+    return frameBytes;
+}
+
+size_t rewindHistory::overheadBytes() const {
+    return (mirror.capacity() + working.capacity()) * sizeof(historyRecord) + mirrorLive.capacity() +
+           workingLive.capacity() + changed.capacity() + dirtyMark.capacity() + dirty.capacity() * sizeof(int);
+}
+
+double rewindHistory::lastSeekMillis() const {
+    return lastSeekMs;
+}
+
+double rewindHistory::lastRecordMillis() const {
+    return lastRecordMs;
+}
+
+int rewindHistory::lastRecordReported() const {
+    return lastReported;
+}
@@ -0,0 +1,158 @@
+// rewindHistory: bounded in-memory history of simulation steps for rewinding and scrubbing.
+/**
+ * @brief Ring of recorded steps: periodic keyframes plus per-step deltas (simulation thread only).
+ * - record() runs after a step (every step, or every few when the owner thins it out). A keyframe
+ *   stores every live entity; the frames in between store only the entities whose state changed
+ *   and the slots released since the previous frame, so a settled pile costs almost nothing.
+ *   Keyframes come every HISTORY_KEYFRAME_INTERVAL frames, or sooner once the deltas since the
+ *   last one add up to its size.
+ * - Deltas only look at slots reported through markChanged() since the previous frame, so a delta
+ *   costs a scan of one byte per slot plus the reported bodies. Those are then compared against
+ *   the state as the history reconstructs it, with the tolerances HISTORY_POSITION_EPSILON /
+ *   HISTORY_VELOCITY_EPSILON; restored values are therefore never further than that from what was
+ *   simulated (records hold floats, like the render snapshot).
+ * - Reporting is a contract, not a hint: every code path that changes a pooled entity between two
+ *   frames must call markChanged() for it. In this tree those are the integrator and the N-body
+ *   pass (integrated bodies), pair resolution (both bodies of a touching pair), the bounds pass
+ *   (bodies it clamps or flags), contact coloring (contact begin and end), and the command drain
+ *   (command targets, spawned and released slots). A change nobody reports would be missing from
+ *   the deltas until the next keyframe; building with HISTORY_VERIFY_MARKS=1 diffs every
+ *   unreported slot on each delta and aborts, naming the slot, when one of them has changed.
+ * - Recorded frames are kept within HISTORY_MEMORY_MB; the oldest keyframe and its deltas are
+ *   dropped together when the budget is exceeded (the newest group is always kept, so the bound
+ *   is the budget or about two keyframes, whichever is larger).
+ * - begin() / seek() / resume() navigate: seek() rewrites the entity pool to the chosen step,
+ *   replaying deltas forward from the nearest keyframe (or from the current step when scrubbing
+ *   forward); resume() discards the steps after the current one and continues recording from there.
+ *   Solver-internal state (contacts, sleep counters, substep levels) is not recorded; it settles
+ *   again within a few steps of resuming.
+ */
+#ifndef rewindHistory_h
+#define rewindHistory_h
+#include "Entity.h"
+#include "raylib.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+/** Where a rewindHistory reads entities from and writes them back to (the players pool in the demo). */
+struct historyPool {
+    std::vector<Entity*> *slots;                          ///< slot -> entity, nullptr when free
+    std::function<int()> slotEnd;                         ///< one past the highest slot in use
+    std::function<void(const std::vector<int> &)> occupy; ///< make free slots live (their state is written afterwards)
+    std::function<void(int)> release;                     ///< free a live slot
+};
+
+/** One entity as recorded (44 bytes). */
+struct historyRecord {
+    int32_t slot;
+    float x, y, vx, vy, radius, weight;
+    uint32_t layer, mask; ///< collision filter
+    Color color;
+    uint8_t flags; ///< HISTORY_* bits
+};
+
+enum historyFlag : uint8_t {
+    HISTORY_STATIC = 1u << 0,
+    HISTORY_BOUNCY = 1u << 1,
+    HISTORY_CAN_MOVE = 1u << 2,
+    HISTORY_ON_GROUND = 1u << 3,
+    HISTORY_AT_CEILING = 1u << 4,
+    HISTORY_AT_LEFT = 1u << 5,
+    HISTORY_AT_RIGHT = 1u << 6,
+};
+
+class rewindHistory {
+    private:
+    struct historyFrame {
+        long long step{0};
+        bool keyframe{false};
+        std::vector<historyRecord> records; // keyframe: every live entity; delta: changed entities
+        std::vector<int32_t> removed;       // delta only: slots released since the previous frame
+    };
+    struct recordScratch {
+        std::vector<historyRecord> records;
+        std::vector<int32_t> removed;
+        int reported{0};
+        int unreportedChange{-1}; // HISTORY_VERIFY_MARKS: a slot that changed without being reported
+    };
+    historyPool pool;
+    size_t budgetBytes;
+    int keyframeInterval;
+    std::deque<historyFrame> frames;
+    int keyframes{0};            // keyframes among `frames`
+    std::vector<recordScratch> scratch; // per parallelFor worker, reused by record()
+    size_t frameBytes{0};        // storage held by `frames`
+    int sinceKeyframe{0};        // frames recorded since the newest keyframe
+    size_t keyframeBytes{0};     // size of the newest keyframe
+    size_t deltaBytes{0};        // size of the deltas recorded after it
+    // State as reconstructed at the newest frame (recording) and at the cursor (navigating), by slot.
+    std::vector<historyRecord> mirror;
+    std::vector<uint8_t> mirrorLive;
+    std::vector<uint8_t> changed; // per slot: reported by markChanged() since the last frame
+    std::vector<historyRecord> working;
+    std::vector<uint8_t> workingLive;
+    std::vector<int> dirty;      // slots of `working` changed since it was last written to the pool
+    std::vector<uint8_t> dirtyMark;
+    bool rewinding{false};
+    int cursor{-1};              // index into `frames` while rewinding
+    double lastSeekMs{0.0};
+    double lastRecordMs{0.0};
+    int lastReported{0};
+    static size_t bytesOf(const historyFrame &frame);
+    void ensureSlots(size_t count);
+    void markDirty(int slot);
+    void applyFrame(const historyFrame &frame);
+    void writeDirtyToPool();
+    void evict();
+    public:
+    /** `slotCapacity` bounds the slots markChanged() can report (the pool's capacity). */
+    rewindHistory(historyPool pool, size_t memoryBytes, int keyframeInterval, int slotCapacity);
+
+    /**
+     * Report that the entity in `slot` may have changed, or was spawned or released, since the last
+     * frame. Workers may call it concurrently for distinct slots; slots beyond the capacity are ignored.
+     */
+    void markChanged(int slot);
+
+    /** Append the pool's current state as step `step` (ignored while rewinding). */
+    void record(long long step);
+
+    /** Drop every recorded frame (recording off); the next record() starts with a keyframe. */
+    void clear();
+
+    /**
+     * Enter rewind mode at the newest frame; recording stops until resume(). The pool must hold
+     * exactly that frame, so an owner that does not record every step records the current one first.
+     */
+    void begin();
+    /**
+     * Restore the frame `offset` steps before the newest (clamped to the window) into the pool.
+     * Returns the offset actually restored.
+     */
+    int seek(int offset);
+    /** Leave rewind mode: drop every frame after the cursor and record on from it. */
+    void resume();
+    bool isRewinding() const;
+
+    int frameCount() const;
+    int keyframeCount() const;
+    /** Steps back from the newest frame to the cursor (0 when not rewinding). */
+    int cursorOffset() const;
+    /** Step number of the cursor frame (of the newest frame when not rewinding; 0 when empty). */
+    long long cursorStep() const;
+    /** Steps between the oldest and the newest frame (frames may be several steps apart). */
+    long long stepSpan() const;
+    /** Bytes held by recorded frames (the part bounded by the memory budget). */
+    size_t memoryBytes() const;
+    /** Bytes of the per-slot reconstruction state, outside the budget. */
+    size_t overheadBytes() const;
+    /** Wall time of the last seek(). */
+    double lastSeekMillis() const;
+    /** Wall time of the last record(), and the slots it examined (every slot for a keyframe). */
+    double lastRecordMillis() const;
+    int lastRecordReported() const;
+};
+#endif // rewindHistory_h
@@ -0,0 +1,158 @@
+// simulation implementation: fixed-rate stepping loop and triple-buffered snapshot hand-off.
+
+#include "simulation.h"
+#include "commands.h"
+#include "config.h"
+#include <algorithm>
+#include <chrono>
+
+// One entity into the export arrays at index n.
+static void writeExportRecord(const exportFrameArrays &out, uint32_t n, const Entity &entity){
+    out.x[n] = static_cast<float>(entity.get_x());
+    out.y[n] = static_cast<float>(entity.get_y());
+    out.vx[n] = static_cast<float>(entity.get_vx());
+    out.vy[n] = static_cast<float>(entity.get_vy());
+    out.radius[n] = static_cast<float>(entity.get_radius());
+    out.flags[n] = (entity.getEntityStatic() ? EXPORT_STATIC : 0u) | (entity.getEntityBouncy() ? EXPORT_BOUNCY : 0u) |
+                   (entity.getOnGround() ? EXPORT_ON_GROUND : 0u) | (entity.getCanMove() ? EXPORT_CAN_MOVE : 0u);
+    out.slot[n] = entity.get_id();
+}
+
+void exportEntityState(long long stepIndex){
+    if (!stateExport.isOpen()) return;
+    exportFrameArrays out = stateExport.beginFrame();
+    uint32_t n = 0;
+    int end = entitySlotEnd();
+    for (int i = 0; i < end && n < out.capacity; ++i) {
+        if (players[i]) writeExportRecord(out, n++, *players[i]);
+    }
+    stateExport.publish(n, static_cast<uint64_t>(stepIndex));
+}
+
+renderSnapshot &snapshotBuffer::writeBuffer(){
+    return buffers[back];
+}
+
+void snapshotBuffer::publish(){
+    // Swap the filled back buffer into the middle slot; take whatever was there as the next back buffer.
+    int previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+    back = previous & 3;
+}
+
+const renderSnapshot &snapshotBuffer::readLatest(){
+    // Only swap when the writer has published since our last read; otherwise keep showing the current front.
+    if (middle.load(std::memory_order_acquire) & FRESH) {
+        int previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & 3;
+    }
+    return buffers[front];
+}
+
+simulationThread::simulationThread(std::function<void(double)> step) : step(std::move(step)) {}
+
+simulationThread::~simulationThread(){
+    stop();
+}
+
+void simulationThread::start(){
+    if (running.exchange(true)) return;
+    worker = std::thread(&simulationThread::run, this);
+}
+
+void simulationThread::stop(){
+    running.store(false);
+    if (worker.joinable()) worker.join();
+}
+
+const renderSnapshot &simulationThread::latest(){
+    return snapshots.readLatest();
+}
+
+void simulationThread::run(){
+    using clock = std::chrono::steady_clock;
+    const double dt = 1.0 / SIM_STEP_HZ;
+    const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
+    auto next = clock::now();
+    long long stepIndex = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        auto begin = clock::now();
+        step(dt);
+        double stepMs = std::chrono::duration<double, std::milli>(clock::now() - begin).count();
+        writeSnapshot(++stepIndex, stepMs);
+
+        // Fixed-rate pacing. If a step overruns by several periods, drop the backlog instead of spiralling.
+        next += period;
+        auto now = clock::now();
+        if (now > next + 4 * period) {
+            next = now;
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void simulationThread::writeSnapshot(long long stepIndex, double stepMs){
+    renderSnapshot &snap = snapshots.writeBuffer();
+    size_t end = static_cast<size_t>(entitySlotEnd());
+    if (snap.x.size() < end) {
+        snap.x.resize(end);
+        snap.y.resize(end);
+        snap.radius.resize(end);
+        snap.color.resize(end);
+    }
+    // The shared-memory export rides on this pass so each entity is read once per step.
+    const bool exporting = stateExport.isOpen();
+    exportFrameArrays out{};
+    if (exporting) out = stateExport.beginFrame();
+    size_t n = 0;
+    for (size_t i = 0; i < end; ++i) {
+        const Entity *entity = players[i];
+        if (!entity) continue;
+        snap.x[n] = static_cast<float>(entity->get_x());
+        snap.y[n] = static_cast<float>(entity->get_y());
+        snap.radius[n] = static_cast<float>(entity->get_radius());
+        snap.color[n] = entity->get_color();
+        if (exporting && n < out.capacity) writeExportRecord(out, static_cast<uint32_t>(n), *entity);
+        ++n;
+    }
+    snap.count = n;
+    if (exporting) stateExport.publish(static_cast<uint32_t>(std::min<size_t>(n, out.capacity)), stepIndex);
+    int hovered = inputMgr.getHovered();
+    int selected = inputMgr.getSelected();
+    snap.hasHover = hovered >= 0 && players[hovered];
+    if (snap.hasHover) {
+        snap.hoverCenter = Vector2{static_cast<float>(players[hovered]->get_x()), static_cast<float>(players[hovered]->get_y())};
+        snap.hoverRadius = static_cast<float>(players[hovered]->get_radius());
+    }
+    snap.hasSelection = selected >= 0 && players[selected];
+    if (snap.hasSelection) {
+        snap.selectionCenter = Vector2{static_cast<float>(players[selected]->get_x()), static_cast<float>(players[selected]->get_y())};
+        snap.selectionRadius = static_cast<float>(players[selected]->get_radius());
+    }
+    const Entity *focus = snap.hasSelection ? players[selected] : players[0];
+    snap.hasFocus = focus != nullptr;
+    if (snap.hasFocus) snap.focus = *focus;
+    for (int level = 0; level <= MAX_SUBSTEP_LEVEL; ++level) {
+        snap.substepBodies[level] = physics.bodiesAtSubstepLevel(level);
+    }
+    snap.bodiesAsleep = physics.bodiesAsleep();
+    snap.maxSubstepLevel = physics.getMaxSubstepLevel();
+    snap.solverIterations = solverIterations;
+    snap.sleepSpeed = static_cast<float>(physics.getSleepSpeed());
+    snap.commands = commandStats;
+    snap.behavioursActive = behaviours.active();
+    snap.behavioursResumed = behaviours.resumedLastStep();
+    snap.behaviourMs = behaviours.lastAdvanceMs();
+    snap.rewinding = stepHistory.isRewinding();
+    snap.rewindOffset = stepHistory.cursorOffset();
+    snap.historyFrames = stepHistory.frameCount();
+    snap.historySteps = stepHistory.stepSpan();
+    snap.historyInterval = historyInterval;
+    snap.historyStep = stepHistory.cursorStep();
+    snap.historyMB = stepHistory.memoryBytes() / (1024.0 * 1024.0);
+    snap.seekMs = stepHistory.lastSeekMillis();
+    snap.hasDiagnostics = diagnosticsEnabled.load(std::memory_order_relaxed);
+    if (snap.hasDiagnostics) snap.diagnostics = lastDiagnostics;
+    snap.step = stepIndex;
+    snap.stepMs = stepMs;
+    snapshots.publish();
+}
@@ -0,0 +1,99 @@
+// simulation: runs the physics step on its own thread and hands render snapshots to the main thread.
+/**
+ * @brief Decouples simulation from presentation.
+ * - simulationThread calls the step callback at a fixed rate (SIM_STEP_HZ) on a worker thread.
+ * - After every step it copies positions, radii and colors into a snapshotBuffer.
+ * - The main thread draws from the latest published snapshot; neither side ever waits on the other.
+ * - When stateExport is open, the same pass also writes the shared-memory frame for external readers.
+ */
+#ifndef simulation_h
+#define simulation_h
+#include "Entity.h"
+#include "raylib.h"
+#include "config.h"
+#include "diagnostics.h"
+#include "commandQueue.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/** Immutable per-step view of the world consumed by the renderer. */
+struct renderSnapshot {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> radius;
+    std::vector<Color> color;
+    size_t count{0};        ///< number of valid entries in the arrays above
+    bool hasFocus{false};
+    Entity focus;           ///< copy of the overlay entity (the selection, else players[0]) at publish time
+    bool hasHover{false};
+    Vector2 hoverCenter{0.0f, 0.0f}; ///< entity under the mouse, outlined by the renderer
+    float hoverRadius{0.0f};
+    bool hasSelection{false};
+    Vector2 selectionCenter{0.0f, 0.0f};
+    float selectionRadius{0.0f};
+    int substepBodies[MAX_SUBSTEP_LEVEL + 1]{}; ///< bodies integrated at each substep level
+    int bodiesAsleep{0};
+    int maxSubstepLevel{MAX_SUBSTEP_LEVEL}; ///< step budget knobs in effect for this step
+    int solverIterations{SOLVER_ITERATIONS};
+    float sleepSpeed{0.0f};
+    commandQueueStats commands;     ///< command queue counters after this step's drain
+    int behavioursActive{0};        ///< scripted behaviours pending, and those resumed this step
+    int behavioursResumed{0};
+    double behaviourMs{0.0};
+    bool rewinding{false};          ///< paused on a recorded step (stepHistory)
+    int rewindOffset{0};            ///< steps back from the newest recorded one
+    int historyFrames{0};
+    long long historySteps{0};      ///< steps covered by the recorded frames
+    int historyInterval{1};         ///< steps per recorded frame chosen by the step budget
+    long long historyStep{0};       ///< step shown (the newest recorded one unless rewinding)
+    double historyMB{0.0};
+    double seekMs{0.0};             ///< cost of the last restore
+    bool hasDiagnostics{false};
+    stepDiagnostics diagnostics; ///< valid when hasDiagnostics (diagnostics stage enabled)
+    long long step{0};      ///< simulation step that produced this snapshot
+    double stepMs{0.0};     ///< wall time spent in that step
+};
+
+/**
+ * @brief Lock-free triple buffer: one writer, one reader, never blocking.
+ * The writer fills writeBuffer() and publish()es it; the reader calls readLatest()
+ * and keeps using the returned snapshot until its next call.
+ */
+class snapshotBuffer {
+    private:
+    static constexpr int FRESH = 4; // set in `middle` when it holds an unread snapshot
+    renderSnapshot buffers[3];
+    std::atomic<int> middle{1};
+    int back{0};  // owned by the writer
+    int front{2}; // owned by the reader
+    public:
+    renderSnapshot &writeBuffer();
+    void publish();
+    const renderSnapshot &readLatest();
+};
+
+/** Publish the current entities to stateExport from the calling thread (headless runner; no-op when closed). */
+void exportEntityState(long long stepIndex);
+
+/** Runs `step(dt)` at SIM_STEP_HZ on a worker thread and publishes a snapshot after each step. */
+class simulationThread {
+    private:
+    std::function<void(double)> step;
+    snapshotBuffer snapshots;
+    std::atomic<bool> running{false};
+    std::thread worker;
+    void run();
+    void writeSnapshot(long long stepIndex, double stepMs);
+    public:
+    explicit simulationThread(std::function<void(double)> step);
+    ~simulationThread();
+
+    void start();
+    /** Signal the worker to finish its current step and join it. */
+    void stop();
+    /** Latest published snapshot (main thread only). */
+    const renderSnapshot &latest();
+};
+#endif // simulation_h
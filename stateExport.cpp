@@ -0,0 +1,298 @@
+// stateExport implementation: shared-memory region setup per platform and the per-slot seqlock.
+// Deliberately raylib-free (see stateExport.h): <windows.h> and raylib.h cannot share a translation unit.
+
+#include "stateExport.h"
+#include <algorithm>
+#include <chrono>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint32_t STATE_EXPORT_MAGIC = 0x53594850; // "PHYS"
+constexpr uint32_t STATE_EXPORT_VERSION = 1;
+constexpr int EXPORT_ARRAYS = 7; // x, y, vx, vy, radius, flags, slot
+
+size_t alignUp(size_t value, size_t alignment){
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t frameBytesFor(uint32_t arrayStride){
+    return sizeof(exportFrameHeader) + static_cast<size_t>(EXPORT_ARRAYS) * arrayStride;
+}
+
+size_t regionBytesFor(uint64_t frameBytes){
+    return sizeof(exportRegionHeader) + 2 * frameBytes;
+}
+
+// Platform layer: create a writable region, open an existing one read-only, unmap, remove.
+#ifdef _WIN32
+std::string osName(const std::string &name){
+    return "Local\\" + name;
+}
+
+void *createRegion(const std::string &name, size_t bytes, void *&handle){
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32),
+                                        static_cast<DWORD>(bytes & 0xFFFFFFFFu), osName(name).c_str());
+    if (!mapping) return nullptr;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Another process still holds a region of this name, possibly with a different size.
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    void *base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!base) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    handle = mapping;
+    return base;
+}
+
+const void *openRegion(const std::string &name, size_t &bytes, void *&handle){
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, osName(name).c_str());
+    if (!mapping) return nullptr;
+    void *base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (!base || VirtualQuery(base, &info, sizeof(info)) == 0) {
+        if (base) UnmapViewOfFile(base);
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    bytes = info.RegionSize;
+    handle = mapping;
+    return base;
+}
+
+void unmapRegion(const void *base, size_t, void *handle){
+    UnmapViewOfFile(base);
+    CloseHandle(static_cast<HANDLE>(handle));
+}
+
+void removeRegion(const std::string &){
+    // Named mappings disappear with their last handle.
+}
+#else
+std::string osName(const std::string &name){
+    return "/" + name;
+}
+
+void *createRegion(const std::string &name, size_t bytes, void *&){
+    // Start from a fresh object: readers of a previous run keep their old mapping, unaffected.
+    shm_unlink(osName(name).c_str());
+    int fd = shm_open(osName(name).c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        close(fd);
+        shm_unlink(osName(name).c_str());
+        return nullptr;
+    }
+    void *base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(osName(name).c_str());
+        return nullptr;
+    }
+    return base;
+}
+
+const void *openRegion(const std::string &name, size_t &bytes, void *&){
+    int fd = shm_open(osName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    bytes = static_cast<size_t>(info.st_size);
+    void *base = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return base == MAP_FAILED ? nullptr : base;
+}
+
+void unmapRegion(const void *base, size_t bytes, void *){
+    munmap(const_cast<void *>(base), bytes);
+}
+
+void removeRegion(const std::string &name){
+    shm_unlink(osName(name).c_str());
+}
+#endif
+
+} // namespace
+
+int64_t exportClockNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+stateWriter::~stateWriter(){
+    close();
+}
+
+exportRegionHeader *stateWriter::header() const {
+    return static_cast<exportRegionHeader *>(base);
+}
+
+exportFrameHeader *stateWriter::frameHeader(int frame) const {
+    char *bytes = static_cast<char *>(base) + sizeof(exportRegionHeader) + frame * header()->frameBytes;
+    return reinterpret_cast<exportFrameHeader *>(bytes);
+}
+
+bool stateWriter::open(const char *name, uint32_t capacity){
+    close();
+    uint32_t arrayStride = static_cast<uint32_t>(alignUp(static_cast<size_t>(capacity) * 4, 64));
+    size_t frameBytes = frameBytesFor(arrayStride);
+    size_t bytes = regionBytesFor(frameBytes);
+    base = createRegion(name, bytes, osHandle);
+    if (!base) return false;
+    mappedBytes = bytes;
+    regionName = name;
+
+    // Fresh pages are zero; only headers are touched here, arrays fault in as frames are written.
+    exportRegionHeader *region = new (base) exportRegionHeader();
+    region->version = STATE_EXPORT_VERSION;
+    region->capacity = capacity;
+    region->arrayStride = arrayStride;
+    region->frameBytes = frameBytes;
+    region->latest.store(2, std::memory_order_relaxed);
+    region->published.store(0, std::memory_order_relaxed);
+    for (int frame = 0; frame < 2; ++frame) new (frameHeader(frame)) exportFrameHeader();
+    region->magic.store(STATE_EXPORT_MAGIC, std::memory_order_release);
+    return true;
+}
+
+void stateWriter::close(){
+    if (!base) return;
+    unmapRegion(base, mappedBytes, osHandle);
+    removeRegion(regionName);
+    base = nullptr;
+    mappedBytes = 0;
+    osHandle = nullptr;
+    fillingFrame = -1;
+}
+
+bool stateWriter::isOpen() const {
+    return base != nullptr;
+}
+
+exportFrameArrays stateWriter::beginFrame(){
+    // Fill the slot readers are least likely to be on: the one not published last.
+    fillingFrame = header()->latest.load(std::memory_order_relaxed) == 0 ? 1 : 0;
+    exportFrameHeader *frame = frameHeader(fillingFrame);
+    frame->sequence.store(frame->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char *arrays = reinterpret_cast<char *>(frame) + sizeof(exportFrameHeader);
+    uint32_t stride = header()->arrayStride;
+    return exportFrameArrays{reinterpret_cast<float *>(arrays),
+                             reinterpret_cast<float *>(arrays + stride),
+                             reinterpret_cast<float *>(arrays + 2 * stride),
+                             reinterpret_cast<float *>(arrays + 3 * stride),
+                             reinterpret_cast<float *>(arrays + 4 * stride),
+                             reinterpret_cast<uint32_t *>(arrays + 5 * stride),
+                             reinterpret_cast<int32_t *>(arrays + 6 * stride),
+                             header()->capacity};
+}
+
+void stateWriter::publish(uint32_t count, uint64_t step){
+    if (fillingFrame < 0) return;
+    exportFrameHeader *frame = frameHeader(fillingFrame);
+    frame->step = step;
+    frame->count = std::min(count, header()->capacity);
+    frame->publishNs = exportClockNs();
+    frame->sequence.store(frame->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    header()->latest.store(static_cast<uint32_t>(fillingFrame), std::memory_order_release);
+    header()->published.fetch_add(1, std::memory_order_release);
+    fillingFrame = -1;
+}
+
+stateReader::~stateReader(){
+    close();
+}
+
+const exportRegionHeader *stateReader::header() const {
+    return static_cast<const exportRegionHeader *>(base);
+}
+
+const exportFrameHeader *stateReader::frameHeader(int frame) const {
+    const char *bytes = static_cast<const char *>(base) + sizeof(exportRegionHeader) + frame * header()->frameBytes;
+    return reinterpret_cast<const exportFrameHeader *>(bytes);
+}
+
+bool stateReader::open(const char *name){
+    close();
+    base = openRegion(name, mappedBytes, osHandle);
+    if (!base) return false;
+    const exportRegionHeader *region = header();
+    bool valid = mappedBytes >= sizeof(exportRegionHeader) &&
+                 region->magic.load(std::memory_order_acquire) == STATE_EXPORT_MAGIC &&
+                 region->version == STATE_EXPORT_VERSION &&
+                 region->frameBytes == frameBytesFor(region->arrayStride) &&
+                 mappedBytes >= regionBytesFor(region->frameBytes);
+    if (!valid) close();
+    return valid;
+}
+
+void stateReader::close(){
+    if (!base) return;
+    unmapRegion(base, mappedBytes, osHandle);
+    base = nullptr;
+    mappedBytes = 0;
+    osHandle = nullptr;
+}
+
+bool stateReader::isOpen() const {
+    return base != nullptr;
+}
+
+uint64_t stateReader::published() const {
+    return header()->published.load(std::memory_order_acquire);
+}
+
+bool stateReader::latest(stateFrameView &view) const {
+    // A few attempts: if the writer lapped us between loading `latest` and the slot's sequence,
+    // the other slot has just become the latest one.
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        uint32_t frame = header()->latest.load(std::memory_order_acquire);
+        if (frame > 1) return false;
+        const exportFrameHeader *slotHeader = frameHeader(static_cast<int>(frame));
+        uint64_t sequence = slotHeader->sequence.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+
+        const char *arrays = reinterpret_cast<const char *>(slotHeader) + sizeof(exportFrameHeader);
+        uint32_t stride = header()->arrayStride;
+        view.x = reinterpret_cast<const float *>(arrays);
+        view.y = reinterpret_cast<const float *>(arrays + stride);
+        view.vx = reinterpret_cast<const float *>(arrays + 2 * stride);
+        view.vy = reinterpret_cast<const float *>(arrays + 3 * stride);
+        view.radius = reinterpret_cast<const float *>(arrays + 4 * stride);
+        view.flags = reinterpret_cast<const uint32_t *>(arrays + 5 * stride);
+        view.slot = reinterpret_cast<const int32_t *>(arrays + 6 * stride);
+        // Header fields may be torn too; clamp so a torn count never reads past the mapping.
+        view.count = std::min(slotHeader->count, header()->capacity);
+        view.step = slotHeader->step;
+        view.publishNs = slotHeader->publishNs;
+        view.frame = static_cast<int>(frame);
+        view.sequence = sequence;
+        return true;
+    }
+    return false;
+}
+
+bool stateReader::validate(const stateFrameView &view) const {
+    if (view.frame < 0) return false;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return frameHeader(view.frame)->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
@@ -0,0 +1,141 @@
+// stateExport: publishes per-step entity state into named shared memory for external processes.
+/**
+ * @brief Zero-copy state export (writer in the simulation, reader library for external tools).
+ * - The region holds a small header and two frame slots. Each slot is a struct of arrays
+ *   (x, y, vx, vy, radius, flags, slot) sized for `capacity` entities.
+ * - Every slot is guarded by its own sequence counter (seqlock): odd while the writer fills it.
+ *   The writer always fills the slot that was NOT published last, so a reader working on the
+ *   latest frame is only disturbed if it is still reading two publishes later.
+ * - Readers map the region read-only and read the arrays in place, then validate() the sequence;
+ *   nothing is copied and the writer never waits for readers.
+ * This header and stateExport.cpp use only the standard library and the OS mapping API (POSIX
+ * shm_open/mmap, or CreateFileMapping on Windows) and do not include raylib, whose names clash with
+ * <windows.h>. External tools build the reader from these two files alone.
+ */
+#ifndef stateExport_h
+#define stateExport_h
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Bits of the per-entity `flags` array.
+enum exportFlag : uint32_t {
+    EXPORT_STATIC = 1u << 0,
+    EXPORT_BOUNCY = 1u << 1,
+    EXPORT_ON_GROUND = 1u << 2,
+    EXPORT_CAN_MOVE = 1u << 3,
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory seqlock needs lock-free 64-bit atomics");
+
+/** Region header, at offset 0 of the mapping. */
+struct alignas(64) exportRegionHeader {
+    std::atomic<uint32_t> magic;      ///< STATE_EXPORT_MAGIC once the writer has laid out the region
+    uint32_t version;
+    uint32_t capacity;                ///< entities per frame slot
+    uint32_t arrayStride;             ///< bytes between consecutive arrays of a frame (64-byte aligned)
+    uint64_t frameBytes;              ///< bytes per frame slot, header included
+    std::atomic<uint32_t> latest;     ///< slot (0 or 1) of the last published frame; > 1 before the first
+    std::atomic<uint64_t> published;  ///< frames published so far; poll it to detect a new frame
+};
+
+/** Per-slot header, followed by the slot's arrays. */
+struct alignas(64) exportFrameHeader {
+    std::atomic<uint64_t> sequence;   ///< odd while the writer is filling this slot
+    uint64_t step;                    ///< simulation step that produced the frame
+    int64_t publishNs;                ///< steady_clock (system-wide monotonic) time of publish, in ns
+    uint32_t count;                   ///< valid entries in each array
+};
+
+/** Writable arrays of the frame being filled (writer side). */
+struct exportFrameArrays {
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *radius;
+    uint32_t *flags;  ///< exportFlag bits
+    int32_t *slot;    ///< pool slot of the entity (stable while it lives)
+    uint32_t capacity;
+};
+
+/** Read-only view of a published frame, pointing straight into the shared mapping. */
+struct stateFrameView {
+    const float *x{nullptr};
+    const float *y{nullptr};
+    const float *vx{nullptr};
+    const float *vy{nullptr};
+    const float *radius{nullptr};
+    const uint32_t *flags{nullptr};
+    const int32_t *slot{nullptr};
+    uint32_t count{0};
+    uint64_t step{0};
+    int64_t publishNs{0};
+    int frame{-1};        ///< slot index, used by validate()
+    uint64_t sequence{0}; ///< slot sequence when the view was taken
+};
+
+/** Current steady_clock time in ns, on the same scale as exportFrameHeader::publishNs. */
+int64_t exportClockNs();
+
+/** Creates the region and publishes frames (single writer; simulation thread). */
+class stateWriter {
+    private:
+    void *base{nullptr};
+    size_t mappedBytes{0};
+    void *osHandle{nullptr}; // Windows mapping handle; unused on POSIX
+    std::string regionName;
+    int fillingFrame{-1};
+    exportRegionHeader *header() const;
+    exportFrameHeader *frameHeader(int frame) const;
+    public:
+    stateWriter() = default;
+    ~stateWriter();
+    stateWriter(const stateWriter &) = delete;
+    stateWriter &operator=(const stateWriter &) = delete;
+
+    /** Create (or replace) the region `name` sized for `capacity` entities per frame. */
+    bool open(const char *name, uint32_t capacity);
+    /** Unmap and remove the region; readers that still map it keep their view until they close. */
+    void close();
+    bool isOpen() const;
+
+    /** Mark the next slot as being written and return its arrays. */
+    exportFrameArrays beginFrame();
+    /** Publish the slot filled since beginFrame() with `count` entries. */
+    void publish(uint32_t count, uint64_t step);
+};
+
+/**
+ * @brief Maps an existing region read-only (any process on the machine).
+ * Typical loop:
+ *     stateFrameView view;
+ *     if (reader.latest(view)) { ...use view.x[i] etc... if (!reader.validate(view)) retry; }
+ */
+class stateReader {
+    private:
+    const void *base{nullptr};
+    size_t mappedBytes{0};
+    void *osHandle{nullptr};
+    const exportRegionHeader *header() const;
+    const exportFrameHeader *frameHeader(int frame) const;
+    public:
+    stateReader() = default;
+    ~stateReader();
+    stateReader(const stateReader &) = delete;
+    stateReader &operator=(const stateReader &) = delete;
+
+    /** Map the region `name`; fails if it does not exist or was not laid out by a compatible writer. */
+    bool open(const char *name);
+    void close();
+    bool isOpen() const;
+
+    /** Frames published so far (cheap; poll it to wait for a new frame). */
+    uint64_t published() const;
+    /** View of the most recently published frame; false before the first publish. */
+    bool latest(stateFrameView &view) const;
+    /** True if the frame behind `view` was not overwritten since latest() returned it. */
+    bool validate(const stateFrameView &view) const;
+};
+#endif // stateExport_h
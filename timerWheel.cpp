@@ -0,0 +1,56 @@
+// timerWheel implementation: node pool, slot placement by due tick, and cascading between levels.
+
+#include "timerWheel.h"
+#include <algorithm>
+
+timerWheel::timerWheel(){
+    for (auto &level : slots) std::fill(std::begin(level), std::end(level), -1);
+}
+
+void timerWheel::schedule(uint64_t delay, void *payload){
+    int32_t node;
+    if (freeNodes >= 0) {
+        node = freeNodes;
+        freeNodes = nodes[node].next;
+    } else {
+        node = static_cast<int32_t>(nodes.size());
+        nodes.push_back(timerNode{});
+    }
+    nodes[node].payload = payload;
+    nodes[node].due = current + std::clamp<uint64_t>(delay, 1, MAX_DELAY);
+    place(node);
+    ++pending;
+}
+
+void timerWheel::place(int32_t node){
+    // The lowest level whose span covers the remaining delay; the slot comes from the due tick's bits there.
+    timerNode &timer = nodes[node];
+    uint64_t delta = timer.due - current;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (uint64_t{1} << (SLOT_BITS * (level + 1)))) ++level;
+    int32_t &head = slots[level][(timer.due >> (SLOT_BITS * level)) & (SLOTS - 1)];
+    timer.next = head;
+    head = node;
+}
+
+void timerWheel::cascade(int level){
+    if (level >= LEVELS) return;
+    int index = static_cast<int>((current >> (SLOT_BITS * level)) & (SLOTS - 1));
+    // Higher levels first: their timers may land in this level's current slot.
+    if (index == 0) cascade(level + 1);
+    int32_t node = slots[level][index];
+    slots[level][index] = -1;
+    while (node >= 0) {
+        int32_t next = nodes[node].next;
+        place(node);
+        node = next;
+    }
+}
+
+uint64_t timerWheel::now() const {
+    return current;
+}
+
+size_t timerWheel::size() const {
+    return pending;
+}
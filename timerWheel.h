@@ -0,0 +1,94 @@
+// timerWheel: hierarchical timing wheel that fires payloads on the tick they are due.
+/**
+ * @brief Schedules opaque payloads a number of ticks ahead (one tick = one simulation step).
+ * - LEVELS levels of SLOTS (64) slots; level L holds timers due within 64^(L+1) ticks, bucketed
+ *   by the L-th group of SLOT_BITS bits of their due tick (about 19 hours at SIM_STEP_HZ in all).
+ * - advance() moves one tick: when a level's slot index wraps, the next level's current slot is
+ *   redistributed downwards (each timer moves at most LEVELS - 1 times over its life), then every
+ *   timer in the level-0 slot fires. Cost per tick is proportional to the timers due, not to the
+ *   number scheduled.
+ * - Timers live in an index-linked node pool with a free list, so scheduling does not allocate
+ *   once the pool has grown. Not thread-safe.
+ */
+#ifndef timerWheel_h
+#define timerWheel_h
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class timerWheel {
+    public:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr uint64_t MAX_DELAY = (uint64_t{1} << (SLOT_BITS * LEVELS)) - 1; ///< longer delays are clamped
+
+    timerWheel();
+
+    /** Fire `payload` on the advance() `delay` ticks from now (clamped to [1, MAX_DELAY]). */
+    void schedule(uint64_t delay, void *payload);
+
+    /**
+     * Move one tick forward and call `fire(payload)` for each timer due on it. `fire` may schedule
+     * new timers. Returns the number fired.
+     */
+    template <class Fn>
+    int advance(Fn &&fire);
+
+    /** Drop every pending timer, passing each payload to `discard`. */
+    template <class Fn>
+    void clear(Fn &&discard);
+
+    uint64_t now() const;
+    size_t size() const;
+
+    private:
+    struct timerNode {
+        void *payload;
+        uint64_t due;
+        int32_t next;
+    };
+    std::vector<timerNode> nodes;
+    int32_t freeNodes{-1};
+    int32_t slots[LEVELS][SLOTS];
+    uint64_t current{0};
+    size_t pending{0};
+    void place(int32_t node);
+    void cascade(int level);
+};
+
+template <class Fn>
+int timerWheel::advance(Fn &&fire){
+    ++current;
+    if ((current & (SLOTS - 1)) == 0) cascade(1);
+    int32_t node = slots[0][current & (SLOTS - 1)];
+    slots[0][current & (SLOTS - 1)] = -1;
+    int fired = 0;
+    while (node >= 0) {
+        // Free the node before firing, so a payload that reschedules itself can reuse it.
+        timerNode &timer = nodes[node];
+        int32_t next = timer.next;
+        void *payload = timer.payload;
+        timer.next = freeNodes;
+        freeNodes = node;
+        --pending;
+        fire(payload);
+        ++fired;
+        node = next;
+    }
+    return fired;
+}
+
+template <class Fn>
+void timerWheel::clear(Fn &&discard){
+    for (int level = 0; level < LEVELS; ++level) {
+        for (int slot = 0; slot < SLOTS; ++slot) {
+            for (int32_t node = slots[level][slot]; node >= 0; node = nodes[node].next) discard(nodes[node].payload);
+            slots[level][slot] = -1;
+        }
+    }
+    nodes.clear();
+    freeNodes = -1;
+    pending = 0;
+}
+#endif // timerWheel_h
@@ -4,31 +4,29 @@
 #include "raylib.h"
 #include "Entity.h"
 #include "config.h"
+#include "commands.h"
 #include <cmath>
 #include <algorithm>
 
 
 void windowInteractions::addToEntityList(Entity* e) {
-    for (size_t i = 0; i < entity_ptr.size(); i++) {
-        if (entity_ptr[i] == e) {
-            return; // already in list
-        }
-        if (entity_ptr[i] == nullptr) {
-            entity_ptr[i] = e; // added in empty slot
-            return;
-        }
-    }
-    // If we reach here, no empty slot was found; add to the end
-    entity_ptr.push_back(e);
+    // Indexed by pool slot, like physicsEffects.
+    size_t slot = static_cast<size_t>(e->get_id());
+    if (slot >= entity_ptr.size()) entity_ptr.resize(slot + 1, nullptr);
+    entity_ptr[slot] = e;
+}
+void windowInteractions::addRangeToEntityList(Entity* const* entities, size_t count) {
+    for (size_t i = 0; i < count; ++i) addToEntityList(entities[i]);
 }
 void windowInteractions::removeFromEntityList(Entity* e) {
-    entity_ptr.erase(std::remove(entity_ptr.begin(), entity_ptr.end(), e), entity_ptr.end());
+    size_t slot = static_cast<size_t>(e->get_id());
+    if (slot < entity_ptr.size() && entity_ptr[slot] == e) entity_ptr[slot] = nullptr;
 }
 void windowInteractions::checkAllBounds() {
 
     for (auto& entity : entity_ptr) {
-        int width = GetScreenWidth();
-        int height = GetScreenHeight();
+        int width = worldWidth.load(std::memory_order_relaxed);
+        int height = worldHeight.load(std::memory_order_relaxed);
         if (!entity) {
             continue;
         }
@@ -36,15 +34,19 @@ void windowInteractions::checkAllBounds() {
         entity->set_color(RED);
 
         // Ensure radius never exceeds sensible half-screen limits (keeps in-bounds logic safe)
+        bool clamped = false;
         if (entity->get_radius() >= width/2.0 || entity->get_radius() >= height/2.0) {
             entity->set_radius(std::min(width/2.0 , height/2.0));
+            clamped = true;
         }
 
        if (entity->get_radius() >= MAX_RADIUS) {
             entity->set_radius(MAX_RADIUS);
+            clamped = true;
         } 
          if (entity->get_radius() <= MIN_RADIUS) {
                 entity->set_radius(MIN_RADIUS);
+                clamped = true;
           }
         // Check bottom boundary
         if (entity->get_y() + entity->get_radius() >= height) {
@@ -67,10 +69,7 @@ void windowInteractions::checkAllBounds() {
             entity->setAtLeft(true);
         }
         // Ordering of flag checks below determines debug color precedence.
-        // For example: collision (BLUE) may be overridden by ground (GREEN) etc.
-        if (entity->getCollided()) {
-            entity->set_color(BLUE);
-        }
+        // For example: ground (GREEN) is overridden by ceiling (YELLOW) etc.; contacts (BLUE) come last in colorContacts.
         if (entity->getOnGround()) {
             entity->set_color(GREEN);
         }
@@ -86,5 +85,25 @@ void windowInteractions::checkAllBounds() {
                 entity->set_vx(0.0); // stop horizontal movement
             }
         }
+        // Bodies that were not integrated (asleep, pinned) can still be moved or recolored by the walls.
+        if (clamped || entity->getOnGround() || entity->getAtCeiling() || entity->getAtLeft() || entity->getAtRight()) {
+            stepHistory.markChanged(entity->get_id());
+        }
+}
+}
+void windowInteractions::colorContacts(const contactStream &contacts) {
+    for (const contactEvent &event : contacts.getEvents()) {
+        for (entityHandle handle : {event.a, event.b}) {
+            Entity *entity = resolveHandle(handle);
+            if (!entity) continue;
+            if (event.phase != contactPhase::Persist) {
+                stepHistory.markChanged(handle.slot); // the color changes when a contact begins and when it ends
+            }
+            if (event.phase == contactPhase::End) continue;
+            if (entity->getOnGround() || entity->getAtCeiling() || entity->getAtLeft() || entity->getAtRight()) {
+                continue; // boundary color takes precedence
+            }
+            entity->set_color(BLUE);
+        }
+    }
 }
-}
\ No newline at end of file
@@ -3,12 +3,13 @@
  * @brief Manage per-window interactions for Entities (bounds clamping, side/ceiling/floor flags).
  *
  * This class holds raw pointers (non-owning) and provides:
- * - addToEntityList / removeFromEntityList: register/unregister entities
+ * - addToEntityList / removeFromEntityList: register/unregister entities (O(1), indexed by pool slot)
  * - checkAllBounds: clamp positions to current screen size and set state flags
  */
 #ifndef windowInteractions_h
 #define windowInteractions_h
 #include "Entity.h"
+#include "contactEvents.h"
 #include <vector>
 
 class windowInteractions {
@@ -19,12 +20,17 @@ class windowInteractions {
 
     /**
      * @brief Add a non-owning pointer to be checked each frame.
-     * Duplicate pointers are ignored; first available nullptr slot is reused.
+     * Stored at the entity's pool slot (Entity::get_id), so re-adding is a no-op and freed slots are reused.
      */
     void addToEntityList(Entity* e);
 
     /**
-     * @brief Remove a pointer from the list (all occurrences removed).
+     * @brief Register a freshly spawned block of pointers.
+     */
+    void addRangeToEntityList(Entity* const* entities, size_t count);
+
+    /**
+     * @brief Remove a pointer from the list (clears its slot).
      */
     void removeFromEntityList(Entity* e);
 
@@ -34,5 +40,11 @@ class windowInteractions {
      */
     void checkAllBounds();
 
+    /**
+     * @brief Debug coloring for bodies in contact (Begin/Persist events), applied after checkAllBounds.
+     * Bodies already colored by a boundary flag keep that color.
+     */
+    void colorContacts(const contactStream &contacts);
+
 };
 #endif //
\ No newline at end of file